@@ -0,0 +1,171 @@
+/**
+ * @brief Full-color RGB wheel
+ *
+ * Drives all three channels at once from HSV, through the integer color
+ * engine's gamma and white balance tables.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Defines */
+#define RED_PIN         16
+#define GREEN_PIN       17
+#define BLUE_PIN        18
+
+// Per-channel intensity, Q16. Green and blue dies are brighter per mA
+// than red, tune these until full white looks white.
+#define CAL_RED         65536
+#define CAL_GREEN       47186   // 0.72
+#define CAL_BLUE        36045   // 0.55
+
+// 1 runs the LEDs at ~30 kHz with a 12-bit wrap and DMA dithering for the
+// low 4 bits, 0 uses plain 16-bit PWM at ~480 Hz through the channel manager
+#define WHEEL_DITHER    1
+
+#define STEP_DELAY_MS   10
+#define HUE_STEP        64      // Full circle in ~10 s
+#define BENCH_ITERS     10000
+
+/* Includes */
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "hardware/pwm.h"
+
+#include "pwm_dither.h"
+#include "pwm_group.h"
+#include "rgb_color.h"
+#include "rgb_color_ref.h"
+
+/* Globals */
+static rgb_calib_t calib;
+#if WHEEL_DITHER
+static pwm_dither_t dither_rg;      // Red A, green B
+static pwm_dither_t dither_b;
+#else
+static pwm_group_t leds;
+static int out_red, out_green, out_blue;
+#endif
+
+// Conversions per second, integer and float. The bench runs before USB
+// enumerates, the wheel prints them once it connects.
+static uint64_t bench_int_rate;
+static uint64_t bench_float_rate;
+
+/* Prototypes */
+void color_bench(void);
+void color_bench_print(void);
+void hardware_init(void);
+
+/* Code */
+int main()
+{
+    stdio_init_all();
+    hardware_init();
+    color_bench();
+
+    hsv_t hsv = { .h = 0, .s = 255, .v = 255 };
+    bool bench_printed = false;
+
+    while (1) {
+        rgb16_t level = rgb_calib_apply(&calib, rgb_from_hsv(hsv));
+
+#if WHEEL_DITHER
+        pwm_dither_set(&dither_rg, pwm_gpio_to_channel(RED_PIN), level.r);
+        pwm_dither_set(&dither_rg, pwm_gpio_to_channel(GREEN_PIN), level.g);
+        pwm_dither_set(&dither_b, pwm_gpio_to_channel(BLUE_PIN), level.b);
+        hsv.h += HUE_STEP;
+#else
+        // Red and green go out together in one write to their slice
+        pwm_group_set(&leds, out_red, level.r);
+        pwm_group_set(&leds, out_green, level.g);
+        pwm_group_set(&leds, out_blue, level.b);
+        pwm_group_commit(&leds);
+
+        hsv.h += HUE_STEP;
+        if (hsv.h == 0) {
+            printf("pwm: %lu register writes for %lu channel updates in %lu frames\n",
+                   leds.writes, leds.updates, leds.commits);
+        }
+#endif
+        if (!bench_printed && stdio_usb_connected()) {
+            color_bench_print();
+            bench_printed = true;
+        }
+        sleep_ms(STEP_DELAY_MS);
+    }
+}
+
+// Whole HSV to PWM level path, integer engine against the float reference
+void color_bench(void)
+{
+    volatile uint32_t sink = 0;
+    const float scale[3] = {
+        (float) CAL_RED / RGB_CALIB_ONE,
+        (float) CAL_GREEN / RGB_CALIB_ONE,
+        (float) CAL_BLUE / RGB_CALIB_ONE,
+    };
+
+    uint64_t start = time_us_64();
+    for (uint32_t i = 0; i < BENCH_ITERS; i++) {
+        hsv_t hsv = { i * 97, i >> 2, i };
+        rgb16_t out = rgb_calib_apply(&calib, rgb_from_hsv(hsv));
+        sink += out.r ^ out.g ^ out.b;
+    }
+    uint64_t int_us = time_us_64() - start;
+
+    start = time_us_64();
+    for (uint32_t i = 0; i < BENCH_ITERS; i++) {
+        hsv_t hsv = { i * 97, i >> 2, i };
+        rgb_t c = rgb_from_hsv_ref(hsv);
+        sink += rgb_gamma_ref(c.r, scale[0]) ^ rgb_gamma_ref(c.g, scale[1])
+              ^ rgb_gamma_ref(c.b, scale[2]);
+    }
+    uint64_t float_us = time_us_64() - start;
+
+    bench_int_rate = BENCH_ITERS * 1000000ull / int_us;
+    bench_float_rate = BENCH_ITERS * 1000000ull / float_us;
+}
+
+void color_bench_print(void)
+{
+    printf("hsv->pwm: integer %llu conv/s, float %llu conv/s\n", bench_int_rate,
+           bench_float_rate);
+}
+
+/* Initialization functions */
+void hardware_init(void)
+{
+    rgb_calib_init(&calib, CAL_RED, CAL_GREEN, CAL_BLUE);
+
+    pwm_config config = pwm_get_default_config();
+
+#if WHEEL_DITHER
+    uint slice_rg = pwm_gpio_to_slice_num(RED_PIN);
+    uint slice_b = pwm_gpio_to_slice_num(BLUE_PIN);
+
+    gpio_set_function(RED_PIN, GPIO_FUNC_PWM);
+    gpio_set_function(GREEN_PIN, GPIO_FUNC_PWM);
+    gpio_set_function(BLUE_PIN, GPIO_FUNC_PWM);
+
+    pwm_dither_config(&config);
+    pwm_init(slice_rg, &config, false);
+    pwm_init(slice_b, &config, false);
+    pwm_dither_init(&dither_rg, slice_rg);
+    pwm_dither_init(&dither_b, slice_b);
+    pwm_dither_start(&dither_rg);
+    pwm_dither_start(&dither_b);
+    pwm_set_mask_enabled((1u << slice_rg) | (1u << slice_b));
+#else
+    // Red and green share a slice, both slices start together
+    pwm_config_set_clkdiv(&config, 4.f);
+    pwm_group_init(&leds, &config);
+    out_red = pwm_group_add(&leds, RED_PIN);
+    out_green = pwm_group_add(&leds, GREEN_PIN);
+    out_blue = pwm_group_add(&leds, BLUE_PIN);
+    pwm_group_commit(&leds);
+    pwm_group_start(&leds);
+#endif
+}
@@ -0,0 +1,184 @@
+/**
+ * @brief Free-running ADC capture into a DMA ring of blocks
+ *
+ * The ADC converts continuously into its FIFO at the set rate. A data
+ * channel takes one block of samples at a time and chains to a control
+ * channel, which rewrites the data channel's transfer count and so
+ * restarts it. The data channel's write address is never reloaded, it
+ * wraps on the ring's size, so the ring has to be aligned to it. The
+ * restart takes a few system clocks, which the ADC FIFO covers at any
+ * sample rate. The CPU is not involved per sample.
+ *
+ * Each finished block raises one interrupt. Since nothing has to be
+ * rearmed, the handler only works out from the data channel's write
+ * address how many blocks have finished, so it can be held off for
+ * several blocks and still count them all, up to the size of the ring.
+ *
+ * The consumer takes blocks in order with adc_capture_block(). A block
+ * stays valid until num_blocks - 2 further blocks have been captured; if
+ * the consumer falls further behind it skips ahead and counts an overrun.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+#include "adc_capture.h"
+
+/* Globals */
+volatile adc_capture_stats_t adc_capture_stats;
+
+static TaskHandle_t capture_task;
+static uint16_t *capture_ring;
+static uint capture_block_len;
+static uint capture_num_blocks;
+static uint capture_data_chan;
+static uint capture_ctrl_chan;
+
+// What the control channel writes to the data channel's count trigger
+static uint32_t capture_count;
+
+// Blocks finished by the DMA, and taken by the consumer
+static volatile uint32_t capture_head;
+static uint32_t capture_tail;
+
+/* Prototypes */
+static void adc_capture_dma_irq(void);
+
+/* Code */
+// The data channel takes block_len samples from the FIFO and then
+// triggers chain
+static void adc_capture_config(uint chain) {
+    dma_channel_config c = dma_channel_get_default_config(capture_data_chan);
+
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, __builtin_ctz(capture_num_blocks * capture_block_len
+                                                    * sizeof(uint16_t)));
+    channel_config_set_dreq(&c, DREQ_ADC);
+    channel_config_set_chain_to(&c, chain);
+    dma_channel_set_config(capture_data_chan, &c, false);
+}
+
+static uint16_t *adc_capture_block_addr(uint32_t block) {
+    return capture_ring + (block % capture_num_blocks) * capture_block_len;
+}
+
+// Before the scheduler starts. The ring is num_blocks * block_len samples,
+// both powers of 2 and num_blocks at least 4, at most 32 KiB and aligned
+// to its size. task is the one that calls adc_capture_block(). Samples
+// are the raw 12-bit conversions.
+void adc_capture_init(TaskHandle_t task, uint input, uint32_t rate_hz,
+                      uint16_t *ring, uint block_len, uint num_blocks) {
+    uint ring_bytes = num_blocks * block_len * sizeof(uint16_t);
+
+    hard_assert(num_blocks >= 4 && (num_blocks & (num_blocks - 1)) == 0);
+    hard_assert((block_len & (block_len - 1)) == 0 && ring_bytes <= 32768);
+    hard_assert(((uintptr_t) ring & (ring_bytes - 1)) == 0);
+
+    capture_task = task;
+    capture_ring = ring;
+    capture_block_len = block_len;
+    capture_num_blocks = num_blocks;
+    capture_count = block_len;
+
+    adc_init();
+    if (input < 4) {
+        adc_gpio_init(26 + input);
+    }
+    adc_select_input(input);
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_rate_set(rate_hz);
+
+    capture_data_chan = dma_claim_unused_channel(true);
+    capture_ctrl_chan = dma_claim_unused_channel(true);
+
+    adc_capture_config(capture_ctrl_chan);
+    dma_channel_set_read_addr(capture_data_chan, &adc_hw->fifo, false);
+    dma_channel_set_irq1_enabled(capture_data_chan, true);
+
+    dma_channel_config c = dma_channel_get_default_config(capture_ctrl_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    dma_channel_configure(capture_ctrl_chan, &c,
+                          &dma_hw->ch[capture_data_chan].al1_transfer_count_trig,
+                          &capture_count, 1, false);
+
+    irq_add_shared_handler(DMA_IRQ_1, adc_capture_dma_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+}
+
+// The ring starts over from its first block
+void adc_capture_start(void) {
+    capture_head = 0;
+    capture_tail = 0;
+
+    adc_capture_config(capture_ctrl_chan);
+    dma_channel_set_write_addr(capture_data_chan, capture_ring, false);
+    dma_channel_set_trans_count(capture_data_chan, capture_block_len, false);
+    adc_fifo_drain();
+    dma_channel_start(capture_data_chan);
+    adc_run(true);
+}
+
+// Aborting the data channel can still fire its chain, so point the chain
+// at itself first, as pwm_fade_stop() does
+void adc_capture_stop(void) {
+    adc_run(false);
+    adc_capture_config(capture_data_chan);
+    dma_channel_abort(capture_ctrl_chan);
+    dma_channel_abort(capture_data_chan);
+    dma_channel_acknowledge_irq1(capture_data_chan);
+    adc_fifo_drain();
+}
+
+// The oldest block not yet taken, NULL when the consumer has caught up.
+// From the task given to adc_capture_init() only.
+const uint16_t *adc_capture_block(void) {
+    uint32_t head = __atomic_load_n(&capture_head, __ATOMIC_ACQUIRE);
+
+    if (head == capture_tail) {
+        return NULL;
+    }
+
+    // Block head is being written, and the one after it can start before
+    // the interrupt moves head
+    if (head - capture_tail > capture_num_blocks - 2) {
+        adc_capture_stats.overruns += head - capture_tail - (capture_num_blocks - 2);
+        capture_tail = head - (capture_num_blocks - 2);
+    }
+    return adc_capture_block_addr(capture_tail++);
+}
+
+/* Interrupt handlers */
+// Acknowledged before the write address is read, so a block that finishes
+// in between raises the interrupt again and at worst finds nothing new
+static void adc_capture_dma_irq(void) {
+    BaseType_t woken = pdFALSE;
+
+    if (!dma_channel_get_irq1_status(capture_data_chan)) {
+        return;     // The interrupt is shared
+    }
+    dma_channel_acknowledge_irq1(capture_data_chan);
+
+    // The block the data channel is in, or about to restart at
+    uintptr_t offset = dma_hw->ch[capture_data_chan].write_addr - (uintptr_t) capture_ring;
+    uint32_t block = offset / (capture_block_len * sizeof(uint16_t));
+    uint32_t done = (block - capture_head) & (capture_num_blocks - 1);
+
+    if (done) {
+        __atomic_store_n(&capture_head, capture_head + done, __ATOMIC_RELEASE);
+        adc_capture_stats.blocks += done;
+        if (capture_task) {
+            vTaskNotifyGiveIndexedFromISR(capture_task, ADC_CAPTURE_NOTIFY_INDEX, &woken);
+        }
+    }
+    portYIELD_FROM_ISR(woken);
+}
@@ -0,0 +1,35 @@
+/**
+ * @brief Free-running ADC capture into a DMA ring of blocks
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+
+#include "adc_rate.h"
+
+// Task notification slot each finished block gives
+#ifndef ADC_CAPTURE_NOTIFY_INDEX
+#define ADC_CAPTURE_NOTIFY_INDEX 2
+#endif
+
+typedef struct {
+    uint32_t blocks;        // Filled by the DMA
+    uint32_t overruns;      // Overwritten before adc_capture_block() got them
+} adc_capture_stats_t;
+
+extern volatile adc_capture_stats_t adc_capture_stats;
+
+void adc_capture_init(TaskHandle_t task, uint input, uint32_t rate_hz,
+                      uint16_t *ring, uint block_len, uint num_blocks);
+void adc_capture_start(void);
+void adc_capture_stop(void);
+const uint16_t *adc_capture_block(void);
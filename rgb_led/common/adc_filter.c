@@ -0,0 +1,141 @@
+/**
+ * @brief Fixed-point conditioning for ADC samples
+ *
+ * Raw 12-bit samples go through up to four stages:
+ *
+ *  - Decimation, the mean of 2^n samples scaled to 16 bits. Uncorrelated
+ *    noise drops by 2^(n/2), so 4^k samples give k extra bits.
+ *  - A moving median over the decimated values, which removes lone
+ *    spikes that a mean would smear.
+ *  - A one-pole IIR low pass, kept with ADC_FILTER_IIR_FRAC extra bits so
+ *    small steps are not lost to truncation.
+ *  - A deadband, the reported value only moves once the filtered value
+ *    is further than the band away. The ends of the range always report.
+ *
+ * Only integer adds, shifts and compares, the M0+ has no FPU and no
+ * divide. adc_filter_block() only returns true when the reported value
+ * has changed, so the caller does nothing while the input sits still.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "adc_filter.h"
+
+/* Code */
+void adc_filter_init(adc_filter_t *f, const adc_filter_config_t *cfg) {
+    *f = (adc_filter_t) { *cfg };
+
+    if (f->cfg.decimate_shift > ADC_FILTER_DECIMATE_MAX) {
+        f->cfg.decimate_shift = ADC_FILTER_DECIMATE_MAX;
+    }
+    if (f->cfg.median_len > ADC_FILTER_MEDIAN_MAX) {
+        f->cfg.median_len = ADC_FILTER_MEDIAN_MAX;
+    }
+}
+
+// Keeps sorted[] in order by taking the oldest value out and putting the
+// new one in, one pass each over at most ADC_FILTER_MEDIAN_MAX entries
+static uint16_t adc_filter_median(adc_filter_t *f, uint16_t x) {
+    unsigned len = f->cfg.median_len;
+    unsigned n = f->fill;
+    unsigned i;
+
+    if (n == len) {
+        uint16_t old = f->history[f->pos];
+        for (i = 0; f->sorted[i] != old; i++) {
+        }
+        for (n--; i < n; i++) {
+            f->sorted[i] = f->sorted[i + 1];
+        }
+    } else {
+        f->fill++;
+    }
+    f->history[f->pos] = x;
+    f->pos = f->pos + 1 == len ? 0 : f->pos + 1;
+
+    for (i = n; i > 0 && f->sorted[i - 1] > x; i--) {
+        f->sorted[i] = f->sorted[i - 1];
+    }
+    f->sorted[i] = x;
+
+    return f->sorted[f->fill / 2];
+}
+
+// One decimated value through the rest of the stages
+static bool adc_filter_value(adc_filter_t *f, uint16_t x, uint16_t *out) {
+    if (f->cfg.median_len > 1) {
+        x = adc_filter_median(f, x);
+    }
+
+    if (f->cfg.iir_shift) {
+        int32_t in = (int32_t) x << ADC_FILTER_IIR_FRAC;
+        if (!f->primed) {
+            f->iir = in;
+            f->primed = true;
+        }
+        f->iir += (in - f->iir) >> f->cfg.iir_shift;
+        x = (f->iir + (1 << (ADC_FILTER_IIR_FRAC - 1))) >> ADC_FILTER_IIR_FRAC;
+    }
+
+    if (x < f->cfg.zero) {
+        x = 0;
+    }
+    f->value = x;
+
+    int32_t moved = (int32_t) x - f->out;
+    if (moved == 0) {
+        return false;
+    }
+    if (moved <= f->cfg.deadband && moved >= -f->cfg.deadband
+        && x != 0 && x < ADC_FILTER_FULL) {
+        return false;
+    }
+    f->out = x;
+    *out = x;
+    return true;
+}
+
+// Runs a block of raw 12-bit samples, true when the reported value
+// changed, it is then in out. Blocks need not line up with the decimation.
+bool adc_filter_block(adc_filter_t *f, const uint16_t *samples, uint32_t n, uint16_t *out) {
+    unsigned shift = f->cfg.decimate_shift;
+    uint32_t per = 1u << shift;
+    uint32_t sum = f->sum;
+    uint32_t count = f->count;
+    bool changed = false;
+
+    if (shift == 0) {
+        while (n--) {
+            changed |= adc_filter_value(f, *samples++ << 4, out);
+        }
+        return changed;
+    }
+
+    while (n) {
+        uint32_t take = per - count < n ? per - count : n;
+
+        n -= take;
+        count += take;
+        while (take >= 4) {
+            sum += samples[0] + samples[1] + samples[2] + samples[3];
+            samples += 4;
+            take -= 4;
+        }
+        while (take--) {
+            sum += *samples++;
+        }
+
+        if (count == per) {
+            changed |= adc_filter_value(f, (sum << 4) >> shift, out);
+            sum = 0;
+            count = 0;
+        }
+    }
+
+    f->sum = sum;
+    f->count = count;
+    return changed;
+}
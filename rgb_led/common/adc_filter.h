@@ -0,0 +1,48 @@
+/**
+ * @brief Fixed-point conditioning for ADC samples
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ADC_FILTER_DECIMATE_MAX 12      // Shift, 4096 samples per output
+#define ADC_FILTER_MEDIAN_MAX   9
+#define ADC_FILTER_IIR_FRAC     8       // Extra bits kept by the IIR
+#define ADC_FILTER_FULL         0xFFF0  // 16-bit scale of a 12-bit 4095
+
+// Every stage is optional, 0 turns it off. Values after the decimator are
+// on a 16-bit scale whatever the decimation, so the later settings do
+// not depend on it.
+typedef struct {
+    uint8_t decimate_shift; // Mean of 2^n samples per output
+    uint8_t median_len;     // Odd, moving median of this many outputs
+    uint8_t iir_shift;      // One-pole low pass, y += (x - y) / 2^n
+    uint16_t deadband;      // Output holds until the value moves further
+    uint16_t zero;          // Values below this read as 0
+} adc_filter_config_t;
+
+typedef struct {
+    adc_filter_config_t cfg;
+
+    uint32_t sum;
+    uint32_t count;
+
+    uint16_t history[ADC_FILTER_MEDIAN_MAX];    // Oldest first from pos
+    uint16_t sorted[ADC_FILTER_MEDIAN_MAX];
+    uint8_t pos;
+    uint8_t fill;
+
+    int32_t iir;
+    bool primed;
+
+    uint16_t value;         // Filtered, before the deadband
+    uint16_t out;           // Last value reported
+} adc_filter_t;
+
+void adc_filter_init(adc_filter_t *f, const adc_filter_config_t *cfg);
+bool adc_filter_block(adc_filter_t *f, const uint16_t *samples, uint32_t n, uint16_t *out);
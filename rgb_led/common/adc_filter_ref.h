@@ -0,0 +1,91 @@
+/**
+ * @brief Float reference for the ADC filter pipeline
+ *
+ * The same stages as adc_filter.c written the obvious way, only used to
+ * check and benchmark it on the host.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <math.h>
+#include <string.h>
+
+#include "adc_filter.h"
+
+typedef struct {
+    adc_filter_config_t cfg;
+    float sum;
+    uint32_t count;
+    float history[ADC_FILTER_MEDIAN_MAX];
+    unsigned pos;
+    unsigned fill;
+    float iir;
+    int primed;
+    float value;
+    float out;
+} adc_filter_ref_t;
+
+static inline void adc_filter_ref_init(adc_filter_ref_t *f, const adc_filter_config_t *cfg) {
+    memset(f, 0, sizeof(*f));
+    f->cfg = *cfg;
+}
+
+static inline float adc_filter_ref_median(adc_filter_ref_t *f, float x) {
+    float sorted[ADC_FILTER_MEDIAN_MAX];
+
+    f->history[f->pos] = x;
+    f->pos = (f->pos + 1) % f->cfg.median_len;
+    if (f->fill < f->cfg.median_len) {
+        f->fill++;
+    }
+
+    // The window is tiny, sort a copy
+    memcpy(sorted, f->history, f->fill * sizeof(float));
+    for (unsigned i = 1; i < f->fill; i++) {
+        float v = sorted[i];
+        unsigned j = i;
+        for (; j > 0 && sorted[j - 1] > v; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = v;
+    }
+    return sorted[f->fill / 2];
+}
+
+static inline int adc_filter_ref_sample(adc_filter_ref_t *f, uint16_t sample, float *out) {
+    f->sum += sample;
+    if (++f->count < 1u << f->cfg.decimate_shift) {
+        return 0;
+    }
+
+    float x = f->sum / f->count * 16.0f;
+    f->sum = 0;
+    f->count = 0;
+
+    if (f->cfg.median_len > 1) {
+        x = adc_filter_ref_median(f, x);
+    }
+    if (f->cfg.iir_shift) {
+        if (!f->primed) {
+            f->iir = x;
+            f->primed = 1;
+        }
+        f->iir += (x - f->iir) / (float) (1u << f->cfg.iir_shift);
+        x = f->iir;
+    }
+    if (x < f->cfg.zero) {
+        x = 0;
+    }
+    f->value = x;
+
+    float moved = fabsf(x - f->out);
+    if (moved == 0 || (moved <= f->cfg.deadband && x != 0 && x < ADC_FILTER_FULL)) {
+        return 0;
+    }
+    f->out = x;
+    *out = x;
+    return 1;
+}
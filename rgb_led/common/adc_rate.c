@@ -0,0 +1,22 @@
+/**
+ * @brief ADC conversion rate, shared by capture and scan
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "hardware/adc.h"
+
+#include "adc_rate.h"
+
+/* Code */
+// Conversions per second over all inputs. Takes effect from the next
+// conversion, can be called while running.
+void adc_rate_set(uint32_t rate_hz) {
+    hard_assert(rate_hz >= ADC_RATE_MIN && rate_hz <= ADC_RATE_MAX);
+
+    // A conversion every 1 + div ADC clocks
+    adc_set_clkdiv(48000000.f / rate_hz - 1.f);
+}
@@ -0,0 +1,18 @@
+/**
+ * @brief ADC conversion rate, shared by capture and scan
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+
+// 96 ADC clocks per conversion at 48 MHz, and the slowest the divider goes
+#define ADC_RATE_MAX    500000
+#define ADC_RATE_MIN    733
+
+void adc_rate_set(uint32_t rate_hz);
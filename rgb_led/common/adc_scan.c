@@ -0,0 +1,244 @@
+/**
+ * @brief Round-robin ADC scan with per-input filters and consumers
+ *
+ * The ADC converts the inputs in turn, so its FIFO holds them
+ * interleaved. The DMA cannot stride, so each input gets a channel that
+ * moves a single sample into that input's ring and then chains to the
+ * next input's channel, the last chaining back to the first. Every
+ * sample lands in its own input's buffer with no CPU work at all.
+ *
+ * The FIFO is only 4 deep. If the DMA falls that far behind, the ADC
+ * drops a conversion and from then on every sample would land in the
+ * next input's ring. The timer below checks the FIFO's overflow flag, and
+ * when it is set the scan is stopped and started over from the first
+ * input, at the start of the half being written.
+ *
+ * A channel that completes per sample can't interrupt per block, so a
+ * repeating timer watches the last channel's write pointer four times a
+ * block and notifies the task when it crosses into the other half of its
+ * ring. adc_scan_dispatch() then runs each input's finished block through
+ * its filter and calls its consumer when the filtered value changes. A
+ * block can be read until the one after it is done.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include <assert.h>
+
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+
+#include "adc_rate.h"
+#include "adc_scan.h"
+
+/* Defines */
+#define ADC_SCAN_RING_BYTES (2 * ADC_SCAN_BLOCK_LEN * sizeof(uint16_t))
+
+static_assert((ADC_SCAN_BLOCK_LEN & (ADC_SCAN_BLOCK_LEN - 1)) == 0, "block length is a power of 2");
+static_assert(ADC_SCAN_RING_BYTES <= 32768, "DMA rings are at most 32 KiB");
+
+/* Globals */
+typedef struct {
+    uint chan;
+    bool bound;
+    adc_filter_t filter;
+    adc_scan_consumer_t consumer;
+    void *ctx;
+} adc_scan_input_t;
+
+volatile adc_scan_stats_t adc_scan_stats;
+
+// The DMA wraps each input's writes on its ring size, so rings are
+// aligned to it
+static uint16_t scan_buf[ADC_SCAN_INPUTS][2 * ADC_SCAN_BLOCK_LEN]
+    __attribute__((aligned(ADC_SCAN_RING_BYTES)));
+
+static TaskHandle_t scan_task;
+static adc_scan_input_t scan_inputs[ADC_SCAN_INPUTS];
+static uint scan_order[ADC_SCAN_INPUTS];     // Conversion order
+static uint scan_count;
+static uint32_t scan_mask;
+static int64_t scan_check_us;
+static repeating_timer_t scan_timer;
+
+// Blocks finished, counted by the timer, and taken by the task
+static volatile uint32_t scan_head;
+static uint32_t scan_tail;
+static uint scan_half;
+
+/* Prototypes */
+static bool adc_scan_check(repeating_timer_t *rt);
+
+/* Code */
+// The channel for scan_order[i] moves one sample into its input's ring and
+// then triggers chain
+static void adc_scan_config(uint i, uint chain) {
+    uint input = scan_order[i];
+    dma_channel_config c = dma_channel_get_default_config(scan_inputs[input].chan);
+
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_ring(&c, true, __builtin_ctz(ADC_SCAN_RING_BYTES));
+    channel_config_set_dreq(&c, DREQ_ADC);
+    channel_config_set_chain_to(&c, chain);
+    dma_channel_set_config(scan_inputs[input].chan, &c, false);
+}
+
+// Every input from the start of the half being written, and the first
+// conversion is the first input again
+static void adc_scan_run(void) {
+    for (uint i = 0; i < scan_count; i++) {
+        uint input = scan_order[i];
+
+        adc_scan_config(i, scan_inputs[scan_order[(i + 1) % scan_count]].chan);
+        dma_channel_set_write_addr(scan_inputs[input].chan,
+                                   scan_buf[input] + scan_half * ADC_SCAN_BLOCK_LEN, false);
+    }
+
+    adc_select_input(scan_order[0]);
+    adc_set_round_robin(scan_mask);
+    adc_fifo_drain();
+    hw_set_bits(&adc_hw->fcs, ADC_FCS_OVER_BITS | ADC_FCS_UNDER_BITS);     // Write 1 to clear
+    dma_channel_start(scan_inputs[scan_order[0]].chan);
+    adc_run(true);
+}
+
+// From the timer. Aborting a channel can still fire its chain, so every
+// chain is broken first.
+static void adc_scan_resync(void) {
+    adc_run(false);
+    while (!(adc_hw->cs & ADC_CS_READY_BITS)) {
+        tight_loop_contents();
+    }
+
+    for (uint i = 0; i < scan_count; i++) {
+        adc_scan_config(i, scan_inputs[scan_order[i]].chan);
+    }
+    for (uint i = 0; i < scan_count; i++) {
+        dma_channel_abort(scan_inputs[scan_order[i]].chan);
+    }
+
+    adc_scan_stats.resyncs++;
+    adc_scan_run();
+}
+
+// Before the scheduler starts. At least two inputs, rate_hz is the total
+// conversion rate shared between them. task is the one that calls
+// adc_scan_dispatch().
+void adc_scan_init(TaskHandle_t task, uint input_mask, uint32_t rate_hz) {
+    scan_task = task;
+    scan_mask = input_mask & ((1u << ADC_SCAN_INPUTS) - 1);
+    scan_count = 0;
+
+    adc_init();
+    for (uint i = 0; i < ADC_SCAN_INPUTS; i++) {
+        if (scan_mask & (1u << i)) {
+            scan_order[scan_count++] = i;
+            if (i == ADC_SCAN_TEMP) {
+                adc_set_temp_sensor_enabled(true);
+            } else {
+                adc_gpio_init(26 + i);
+            }
+        }
+    }
+    hard_assert(scan_count >= 2);
+
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_rate_set(rate_hz);
+
+    for (uint i = 0; i < scan_count; i++) {
+        scan_inputs[scan_order[i]].chan = dma_claim_unused_channel(true);
+    }
+    for (uint i = 0; i < scan_count; i++) {
+        uint chan = scan_inputs[scan_order[i]].chan;
+
+        dma_channel_set_read_addr(chan, &adc_hw->fifo, false);
+        dma_channel_set_trans_count(chan, 1, false);
+    }
+
+    // Quarter of a block, in time
+    scan_check_us = (int64_t) ADC_SCAN_BLOCK_LEN * scan_count * 1000000 / rate_hz / 4;
+}
+
+// Input's filtered value goes to consumer, in the task, whenever it
+// changes. Unbound inputs are still sampled, see adc_scan_block().
+void adc_scan_bind(uint input, const adc_filter_config_t *cfg,
+                   adc_scan_consumer_t consumer, void *ctx) {
+    hard_assert(scan_mask & (1u << input));
+
+    adc_filter_init(&scan_inputs[input].filter, cfg);
+    scan_inputs[input].consumer = consumer;
+    scan_inputs[input].ctx = ctx;
+    scan_inputs[input].bound = true;
+}
+
+void adc_scan_start(void) {
+    scan_head = 0;
+    scan_tail = 0;
+    scan_half = 0;
+
+    adc_scan_run();
+    add_repeating_timer_us(-scan_check_us, adc_scan_check, NULL, &scan_timer);
+}
+
+// Raw samples of input's newest finished block, ADC_SCAN_BLOCK_LEN of them,
+// once there has been one. From the task only.
+const uint16_t *adc_scan_block(uint input) {
+    return scan_buf[input] + ((scan_head - 1) & 1) * ADC_SCAN_BLOCK_LEN;
+}
+
+// Filters the finished blocks and calls the consumers, from the task only
+void adc_scan_dispatch(void) {
+    uint32_t head = __atomic_load_n(&scan_head, __ATOMIC_ACQUIRE);
+
+    // The DMA is writing over anything older than the last block
+    if (head - scan_tail > 1) {
+        adc_scan_stats.overruns += head - scan_tail - 1;
+        scan_tail = head - 1;
+    }
+
+    for (; scan_tail != head; scan_tail++) {
+        uint half = scan_tail & 1;
+
+        for (uint i = 0; i < scan_count; i++) {
+            adc_scan_input_t *in = &scan_inputs[scan_order[i]];
+            uint16_t value;
+
+            if (in->bound && adc_filter_block(&in->filter, scan_buf[scan_order[i]]
+                                              + half * ADC_SCAN_BLOCK_LEN,
+                                              ADC_SCAN_BLOCK_LEN, &value)) {
+                in->consumer(scan_order[i], value, in->ctx);
+            }
+        }
+    }
+}
+
+/* Interrupt handlers */
+// The last input of a round is written last, once it is into a half the
+// other half is complete for every input
+static bool adc_scan_check(repeating_timer_t *rt) {
+    // A block with a dropped conversion in it is written again, not counted
+    if (adc_hw->fcs & (ADC_FCS_OVER_BITS | ADC_FCS_UNDER_BITS)) {
+        adc_scan_resync();
+        return true;
+    }
+
+    adc_scan_input_t *last = &scan_inputs[scan_order[scan_count - 1]];
+    uintptr_t written = dma_channel_hw_addr(last->chan)->write_addr
+                        - (uintptr_t) scan_buf[scan_order[scan_count - 1]];
+    uint half = written >= ADC_SCAN_BLOCK_LEN * sizeof(uint16_t);
+    BaseType_t woken = pdFALSE;
+
+    if (half != scan_half) {
+        scan_half = half;
+        __atomic_store_n(&scan_head, scan_head + 1, __ATOMIC_RELEASE);
+        adc_scan_stats.blocks++;
+        vTaskNotifyGiveIndexedFromISR(scan_task, ADC_SCAN_NOTIFY_INDEX, &woken);
+        portYIELD_FROM_ISR(woken);
+    }
+    return true;
+}
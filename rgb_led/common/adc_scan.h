@@ -0,0 +1,48 @@
+/**
+ * @brief Round-robin ADC scan with per-input filters and consumers
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+
+#include "adc_filter.h"
+
+#define ADC_SCAN_INPUTS     5       // AIN0-3 on GPIO 26-29, and temperature
+#define ADC_SCAN_TEMP       4
+
+// Samples per input per block, a power of 2. Each input gets a ring of
+// two blocks.
+#ifndef ADC_SCAN_BLOCK_LEN
+#define ADC_SCAN_BLOCK_LEN  256
+#endif
+
+// Task notification slot each finished block gives
+#ifndef ADC_SCAN_NOTIFY_INDEX
+#define ADC_SCAN_NOTIFY_INDEX 2
+#endif
+
+typedef void (*adc_scan_consumer_t)(uint input, uint16_t value, void *ctx);
+
+typedef struct {
+    uint32_t blocks;
+    uint32_t overruns;      // Blocks overwritten before adc_scan_dispatch()
+    uint32_t resyncs;       // FIFO overflows, each restarts the scan
+} adc_scan_stats_t;
+
+extern volatile adc_scan_stats_t adc_scan_stats;
+
+void adc_scan_init(TaskHandle_t task, uint input_mask, uint32_t rate_hz);
+void adc_scan_bind(uint input, const adc_filter_config_t *cfg,
+                   adc_scan_consumer_t consumer, void *ctx);
+void adc_scan_start(void);
+void adc_scan_dispatch(void);
+const uint16_t *adc_scan_block(uint input);
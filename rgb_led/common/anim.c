@@ -0,0 +1,107 @@
+/**
+ * @brief Keyframe animation engine
+ *
+ * Runs at a fixed frame rate set by whoever calls anim_step(), a hardware
+ * alarm or a FreeRTOS timer, independent of the PWM frequency. Each frame
+ * finds the two keys around the current time, eases the fraction between
+ * them and blends the colors, all in integer math. Effects in a sequence
+ * run back to back for their own durations.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "anim.h"
+
+/* Code */
+void anim_init(anim_t *anim, const anim_seq_t *seq, uint32_t fps) {
+    anim->seq = seq;
+    anim->frame_us = 1000000 / fps;
+    anim->effect = 0;
+    anim->effect_us = 0;
+    anim->done = seq->num_effects == 0;
+    anim->frames = 0;
+}
+
+// t is a Q16 fraction below 1, the result is Q16 up to 1 (65536)
+uint32_t anim_ease(anim_ease_t ease, uint32_t t) {
+    uint32_t t2 = (t * t) >> 16;
+    uint32_t u = 65536 - t;
+
+    switch (ease) {
+        case ANIM_EASE_IN:
+            return t2;
+        case ANIM_EASE_OUT:
+            return 65536 - (uint32_t) (((uint64_t) u * u) >> 16);
+        case ANIM_EASE_IN_OUT:
+            // 3t^2 - 2t^3 = t^2 (3 - 2t)
+            return (uint32_t) (((uint64_t) t2 * ((3u << 16) - 2 * t)) >> 16);
+        case ANIM_EASE_STEP:
+            return t < 65535 ? 0 : 65535;
+        default:
+            return t;
+    }
+}
+
+static uint8_t anim_blend(uint8_t a, uint8_t b, uint32_t f) {
+    return a + (((int32_t) b - a) * (int32_t) f >> 16);
+}
+
+rgb_t anim_sample(const anim_effect_t *effect, uint32_t t_us) {
+    const anim_key_t *keys = effect->keys;
+    uint32_t t_ms = t_us / 1000;
+    uint32_t k = 1;
+
+    if (effect->num_keys == 0) {
+        return (rgb_t) { 0, 0, 0 };
+    }
+    while (k < effect->num_keys && keys[k].time_ms <= t_ms) {
+        k++;
+    }
+    if (k == effect->num_keys) {
+        return keys[k - 1].color;
+    }
+
+    // Fraction through the segment from keys[k - 1] to keys[k]
+    uint32_t span_us = (keys[k].time_ms - keys[k - 1].time_ms) * 1000;
+    uint32_t into_us = t_us - keys[k - 1].time_ms * 1000;
+    uint32_t f = anim_ease(keys[k].ease, (uint32_t) (((uint64_t) into_us << 16) / span_us));
+
+    return (rgb_t) {
+        anim_blend(keys[k - 1].color.r, keys[k].color.r, f),
+        anim_blend(keys[k - 1].color.g, keys[k].color.g, f),
+        anim_blend(keys[k - 1].color.b, keys[k].color.b, f),
+    };
+}
+
+// One frame, the color to show now. A finished sequence holds its last frame.
+rgb_t anim_step(anim_t *anim) {
+    const anim_seq_t *seq = anim->seq;
+
+    if (anim->done) {
+        if (seq->num_effects == 0) {
+            return (rgb_t) { 0, 0, 0 };
+        }
+        const anim_effect_t *last = &seq->effects[seq->num_effects - 1];
+        return anim_sample(last, last->duration_ms * 1000);
+    }
+
+    rgb_t color = anim_sample(&seq->effects[anim->effect], anim->effect_us);
+
+    anim->frames++;
+    anim->effect_us += anim->frame_us;
+    while (anim->effect_us >= seq->effects[anim->effect].duration_ms * 1000) {
+        anim->effect_us -= seq->effects[anim->effect].duration_ms * 1000;
+        if (++anim->effect == seq->num_effects) {
+            anim->effect = 0;
+            if (!seq->loop) {
+                anim->effect = seq->num_effects - 1;
+                anim->done = true;
+                break;
+            }
+        }
+    }
+    return color;
+}
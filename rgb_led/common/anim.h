@@ -0,0 +1,57 @@
+/**
+ * @brief Keyframe animation engine
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rgb_color.h"
+
+typedef enum {
+    ANIM_EASE_LINEAR,
+    ANIM_EASE_IN,           // Quadratic, slow start
+    ANIM_EASE_OUT,          // Quadratic, slow finish
+    ANIM_EASE_IN_OUT,       // Smoothstep
+    ANIM_EASE_STEP,         // Jump at the key
+} anim_ease_t;
+
+// ease shapes the segment that arrives at this key
+typedef struct {
+    uint32_t time_ms;
+    rgb_t color;
+    anim_ease_t ease;
+} anim_key_t;
+
+// Keys in time order from 0, the last color holds until duration_ms,
+// which must not be 0
+typedef struct {
+    const anim_key_t *keys;
+    uint32_t num_keys;
+    uint32_t duration_ms;
+} anim_effect_t;
+
+typedef struct {
+    const anim_effect_t *effects;
+    uint32_t num_effects;
+    bool loop;
+} anim_seq_t;
+
+typedef struct {
+    const anim_seq_t *seq;
+    uint32_t frame_us;
+    uint32_t effect;
+    uint32_t effect_us;
+    bool done;
+
+    uint32_t frames;
+} anim_t;
+
+void anim_init(anim_t *anim, const anim_seq_t *seq, uint32_t fps);
+rgb_t anim_step(anim_t *anim);
+rgb_t anim_sample(const anim_effect_t *effect, uint32_t t_us);
+uint32_t anim_ease(anim_ease_t ease, uint32_t t);
@@ -0,0 +1,156 @@
+/**
+ * @brief Deferred, debounced button events
+ *
+ * The GPIO interrupt only timestamps the edge with the 64-bit timer, puts
+ * it on a single-producer single-consumer ring and notifies the task
+ * given to button_init(). That task calls button_dispatch(), which drops
+ * edges that land within a button's debounce time of its last accepted
+ * one and runs the handlers in task context. Handlers can take as long as
+ * they like and use any task API, nothing else waits on them.
+ *
+ * Both edges are always watched, whatever the caller asked for, so a
+ * release is seen and its bounces are dropped like a press's, never
+ * taken for a second press. Handlers only see the edges they were added
+ * for.
+ *
+ * An edge outside the debounce time is always a real change. When it
+ * leaves the state where it was, the change the other way was one of the
+ * dropped edges, a tap shorter than the debounce time, and is reported
+ * first at that edge's time, so handlers always see press and release
+ * alternate.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+#include "button.h"
+
+/* Globals */
+typedef struct {
+    uint64_t time_us;
+    uint8_t gpio;
+    uint8_t events;
+    bool level;             // Pin as the interrupt found it
+} button_edge_t;
+
+typedef struct {
+    uint gpio;
+    uint32_t debounce_us;
+    button_handler_t handler;
+    uint64_t last_us;       // Last accepted edge
+    uint64_t bounce_us;     // Last dropped one
+    uint32_t edges;         // Reported to the handler
+    bool pressed;
+} button_t;
+
+volatile button_stats_t button_stats;
+
+static TaskHandle_t button_task;
+static button_t buttons[BUTTON_MAX];
+static uint num_buttons;
+
+// Written by the interrupt at head, read by the task at tail
+static button_edge_t button_ring[BUTTON_QUEUE_LEN];
+static volatile uint32_t button_head;
+static volatile uint32_t button_tail;
+
+/* Prototypes */
+static void button_isr(uint gpio, uint32_t events);
+
+/* Code */
+// Before the scheduler starts, task is the one that calls button_dispatch()
+void button_init(TaskHandle_t task, uint8_t irq_priority) {
+    button_task = task;
+    irq_set_priority(IO_IRQ_BANK0, irq_priority);
+}
+
+// Pin is an input pulled up, pressing grounds it
+void button_add(uint gpio, uint32_t edges, uint32_t debounce_us, button_handler_t handler) {
+    hard_assert(num_buttons < BUTTON_MAX);
+
+    gpio_init(gpio);
+    gpio_pull_up(gpio);
+    gpio_set_dir(gpio, GPIO_IN);
+
+    // Held at startup is pressed, its release is the first edge. The
+    // pull-up gets a moment to charge the line first.
+    busy_wait_us(10);
+    buttons[num_buttons++] = (button_t) {
+        gpio, debounce_us, handler, 0, 0, edges, !gpio_get(gpio)
+    };
+    gpio_set_irq_enabled_with_callback(gpio, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true,
+                                       button_isr);
+}
+
+static void button_report(button_t *b, bool press, uint64_t time_us) {
+    b->pressed = press;
+    if (b->edges & (press ? GPIO_IRQ_EDGE_FALL : GPIO_IRQ_EDGE_RISE)) {
+        b->handler(b->gpio, press ? BUTTON_PRESS : BUTTON_RELEASE, time_us);
+    }
+}
+
+// Drains the ring, from the task only
+void button_dispatch(void) {
+    uint32_t head = __atomic_load_n(&button_head, __ATOMIC_ACQUIRE);
+
+    while (button_tail != head) {
+        button_edge_t edge = button_ring[button_tail % BUTTON_QUEUE_LEN];
+        __atomic_store_n(&button_tail, button_tail + 1, __ATOMIC_RELEASE);
+
+        for (uint i = 0; i < num_buttons; i++) {
+            button_t *b = &buttons[i];
+            if (b->gpio != edge.gpio) {
+                continue;
+            }
+
+            // Both edges in one interrupt means it bounced faster than we
+            // could take it, the level says where it ended up
+            uint32_t fall_rise = GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE;
+            bool both = (edge.events & fall_rise) == fall_rise;
+            bool press = both ? !edge.level : edge.events & GPIO_IRQ_EDGE_FALL;
+            if (edge.time_us - b->last_us < b->debounce_us || (both && press == b->pressed)) {
+                button_stats.bounces++;
+                b->bounce_us = edge.time_us;
+                break;
+            }
+
+            // The state is stale, the change back was dropped as a bounce
+            if (press == b->pressed) {
+                button_stats.resyncs++;
+                button_report(b, !press, b->bounce_us > b->last_us ? b->bounce_us : edge.time_us);
+            }
+            b->last_us = edge.time_us;
+            button_report(b, press, edge.time_us);
+            break;
+        }
+    }
+}
+
+/* Interrupt handlers */
+static void button_isr(uint gpio, uint32_t events) {
+    uint64_t now = time_us_64();
+    uint32_t head = button_head;
+    BaseType_t woken = pdFALSE;
+
+    if (head - __atomic_load_n(&button_tail, __ATOMIC_ACQUIRE) < BUTTON_QUEUE_LEN) {
+        button_ring[head % BUTTON_QUEUE_LEN] = (button_edge_t) {
+            now, gpio, events, gpio_get(gpio)
+        };
+        __atomic_store_n(&button_head, head + 1, __ATOMIC_RELEASE);
+    } else {
+        button_stats.dropped++;
+    }
+    vTaskNotifyGiveIndexedFromISR(button_task, BUTTON_NOTIFY_INDEX, &woken);
+
+    uint32_t took = time_us_32() - (uint32_t) now;
+    button_stats.edges++;
+    if (took > button_stats.isr_max_us) {
+        button_stats.isr_max_us = took;
+    }
+    portYIELD_FROM_ISR(woken);
+}
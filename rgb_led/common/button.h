@@ -0,0 +1,45 @@
+/**
+ * @brief Deferred, debounced button events
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "pico/stdlib.h"
+
+#define BUTTON_MAX          8
+#define BUTTON_QUEUE_LEN    32      // Edges in flight, power of 2
+#define BUTTON_DEBOUNCE_US  5000
+
+// Task notification slot the edge interrupt gives
+#ifndef BUTTON_NOTIFY_INDEX
+#define BUTTON_NOTIFY_INDEX 1
+#endif
+
+typedef enum {
+    BUTTON_PRESS,       // Falling edge, buttons pull to ground
+    BUTTON_RELEASE,
+} button_event_t;
+
+typedef void (*button_handler_t)(uint gpio, button_event_t event, uint64_t time_us);
+
+typedef struct {
+    uint32_t edges;
+    uint32_t isr_max_us;    // Worst edge interrupt, including the notify
+    uint32_t dropped;       // Queue full
+    uint32_t bounces;
+    uint32_t resyncs;       // Changes found only from the edge after them
+} button_stats_t;
+
+extern volatile button_stats_t button_stats;
+
+void button_init(TaskHandle_t task, uint8_t irq_priority);
+void button_add(uint gpio, uint32_t edges, uint32_t debounce_us, button_handler_t handler);
+void button_dispatch(void);
@@ -0,0 +1,34 @@
+/**
+ * @brief Temporal dithering of 16-bit levels onto a short PWM wrap
+ *
+ * A 16-bit level is split into a DITHER_RES_BITS compare value and a
+ * fraction. A first-order sigma-delta over DITHER_STEPS periods adds one
+ * count to exactly fraction of them, spread as evenly as it can, so the
+ * mean duty over the pattern is level / 65536 with no error at all.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "dither.h"
+
+/* Code */
+// One compare value per period. cc can reach DITHER_TOP + 1, which the
+// PWM treats as always high.
+void dither_pattern(uint16_t *cc, uint16_t level) {
+    uint16_t whole = level >> DITHER_FRAC_BITS;
+    uint16_t frac = level & (DITHER_STEPS - 1);
+    uint16_t acc = DITHER_STEPS / 2;    // Centered, the carries land mid-pattern
+
+    for (uint16_t i = 0; i < DITHER_STEPS; i++) {
+        acc += frac;
+        if (acc >= DITHER_STEPS) {
+            acc -= DITHER_STEPS;
+            cc[i] = whole + 1;
+        } else {
+            cc[i] = whole;
+        }
+    }
+}
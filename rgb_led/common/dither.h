@@ -0,0 +1,18 @@
+/**
+ * @brief Temporal dithering of 16-bit levels onto a short PWM wrap
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdint.h>
+
+// Compare resolution per period, the rest of the 16 bits is dithered
+#define DITHER_RES_BITS     12
+#define DITHER_FRAC_BITS    (16 - DITHER_RES_BITS)
+#define DITHER_TOP          ((1u << DITHER_RES_BITS) - 1)   // PWM wrap
+#define DITHER_STEPS        (1u << DITHER_FRAC_BITS)        // Periods per pattern
+
+void dither_pattern(uint16_t *cc, uint16_t level);
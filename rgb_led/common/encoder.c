@@ -0,0 +1,69 @@
+/**
+ * @brief Rotary encoder on a PIO quadrature decoder
+ *
+ * The state machine counts every edge in hardware and keeps pushing the
+ * count, so reading it is a FIFO drain at whatever rate suits the caller,
+ * even from an interrupt, and nothing is missed however fast the shaft
+ * spins. encoder_delta() turns counts into whole detents since the last
+ * call and scales them up when the knob is spun quickly.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "encoder.h"
+#include "quadrature.pio.h"
+
+/* Code */
+// Pin B is pin_a + 1. The decoder must sit at offset 0, so load it before
+// any other program on the same PIO.
+void encoder_init(encoder_t *enc, PIO pio, uint pin_a) {
+    enc->pio = pio;
+    enc->sm = pio_claim_unused_sm(pio, true);
+
+    pio_add_program_at_offset(pio, &quadrature_program, 0);
+    quadrature_program_init(pio, enc->sm, 0, pin_a);
+
+    enc->last_count = 0;
+    enc->last_us = time_us_64();
+}
+
+// The newest count, the FIFO is drained to its last entry. The decoder
+// pushes every few cycles so the wait for a fresh one is a few cycles.
+int32_t encoder_count(encoder_t *enc) {
+    uint n = pio_sm_get_rx_fifo_level(enc->pio, enc->sm) + 1;
+    int32_t count = 0;
+
+    while (n--) {
+        count = pio_sm_get_blocking(enc->pio, enc->sm);
+    }
+    return count;
+}
+
+// Step multiplier for detents turned in dt_us
+int32_t encoder_accel(int32_t detents, uint32_t dt_us) {
+    uint32_t n = detents < 0 ? -detents : detents;
+    uint32_t rate = dt_us ? (uint64_t) n * 1000000 / dt_us : 0;
+    uint32_t mult = 1 + rate / ENCODER_ACCEL_RATE;
+
+    return detents * (int32_t) MIN(mult, ENCODER_ACCEL_MAX);
+}
+
+// Accelerated detents since the last call. Partial detents carry over.
+int32_t encoder_delta(encoder_t *enc) {
+    int32_t count = encoder_count(enc);
+    int32_t detents = (count - enc->last_count) / ENCODER_COUNTS_PER_DETENT;
+
+    if (detents == 0) {
+        return 0;
+    }
+
+    uint64_t now = time_us_64();
+    int32_t delta = encoder_accel(detents, now - enc->last_us);
+
+    enc->last_count += detents * ENCODER_COUNTS_PER_DETENT;
+    enc->last_us = now;
+    return delta;
+}
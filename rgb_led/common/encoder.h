@@ -0,0 +1,32 @@
+/**
+ * @brief Rotary encoder on a PIO quadrature decoder
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+
+#define ENCODER_COUNTS_PER_DETENT   4
+
+// Acceleration: every ENCODER_ACCEL_RATE detents/s of spin adds one to
+// the step multiplier, up to ENCODER_ACCEL_MAX
+#define ENCODER_ACCEL_RATE          15
+#define ENCODER_ACCEL_MAX           16
+
+typedef struct {
+    PIO pio;
+    uint sm;
+    int32_t last_count;     // Raw count at the last detent boundary used
+    uint64_t last_us;
+} encoder_t;
+
+void encoder_init(encoder_t *enc, PIO pio, uint pin_a);
+int32_t encoder_count(encoder_t *enc);
+int32_t encoder_delta(encoder_t *enc);
+int32_t encoder_accel(int32_t detents, uint32_t dt_us);
@@ -0,0 +1,220 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2022 Alex Gavin
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+"""Assemble LED effect scripts into fxvm images.
+
+One instruction per line, operands separated by commas, ';' starts a
+comment. Labels end in ':'. '.equ NAME value' defines a constant and
+'.var NAME' gives a name to the next free memory word. 'li rD, value' loads
+any 32-bit constant as LDI, plus LUI when the top half is needed.
+Registers r0, r1 and r2 hold the pixel index, frame number and pixel count
+when each pixel starts. The encoding must match fxvm.h.
+
+Output is a C header (one array per script), raw little-endian words for
+the host harness, or one line of hex words to send to a running board.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+MAGIC = 0x31565846
+CODE_WORDS = 256
+MEM_WORDS = 64
+
+OPS = [
+    "end", "ldi", "lui", "mov", "add", "sub", "mul", "mulq", "addi", "shl",
+    "shr", "and", "or", "xor", "min", "max", "sin", "rnd", "ld", "st", "jmp",
+    "jz", "jnz", "jlt", "rgb", "hsv",
+]
+OPCODE = {name: i for i, name in enumerate(OPS)}
+
+# Operand kinds per op: r register, i16/i12/s12 immediates, m memory, l label
+FORMS = {
+    "end": "", "ldi": "r i16", "lui": "r i16", "mov": "r r",
+    "add": "r r r", "sub": "r r r", "mul": "r r r", "mulq": "r r r",
+    "addi": "r r s12", "shl": "r r i12", "shr": "r r i12",
+    "and": "r r r", "or": "r r r", "xor": "r r r", "min": "r r r", "max": "r r r",
+    "sin": "r r", "rnd": "r", "ld": "r m", "st": "r m",
+    "jmp": "l", "jz": "r l", "jnz": "r l", "jlt": "r r l",
+    "rgb": "r r r", "hsv": "r r r",
+}
+
+# Field each register operand lands in, in order
+REG_FIELDS = {"jz": (16,), "jnz": (16,), "jlt": (16, 12)}
+
+
+class AsmError(Exception):
+    pass
+
+
+def parse_int(text, symbols):
+    text = text.strip()
+    if text in symbols:
+        return symbols[text]
+    try:
+        return int(text, 0)
+    except ValueError:
+        raise AsmError(f"bad number or unknown name '{text}'")
+
+
+def parse_reg(text):
+    m = re.fullmatch(r"r(\d+)", text.strip().lower())
+    if not m or int(m.group(1)) > 15:
+        raise AsmError(f"bad register '{text}'")
+    return int(m.group(1))
+
+
+def split_lines(path):
+    with open(path, encoding="ascii") as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.split(";", 1)[0].strip()
+            if line:
+                yield lineno, line
+
+
+def first_pass(path):
+    """Labels, constants and memory names, and the expanded instruction list."""
+    symbols = {}
+    labels = {}
+    insns = []
+    next_var = 0
+    for lineno, line in split_lines(path):
+        while ":" in line:
+            label, line = line.split(":", 1)
+            labels[label.strip()] = len(insns)
+            line = line.strip()
+        if not line:
+            continue
+        parts = line.split(None, 1)
+        op = parts[0].lower()
+        args = [a.strip() for a in parts[1].split(",")] if len(parts) > 1 else []
+        try:
+            if op == ".equ":
+                name, value = args[0].split(None, 1) if len(args) == 1 else args
+                symbols[name] = parse_int(value, symbols)
+            elif op == ".var":
+                if next_var >= MEM_WORDS:
+                    raise AsmError(f"more than {MEM_WORDS} memory words")
+                symbols[args[0]] = next_var
+                next_var += 1
+            elif op == "li":
+                value = parse_int(args[1], symbols) & 0xFFFFFFFF
+                insns.append((lineno, "ldi", [args[0], str(value & 0xFFFF)]))
+                low_sext = (value & 0xFFFF) - (0x10000 if value & 0x8000 else 0)
+                if (low_sext & 0xFFFFFFFF) != value:
+                    insns.append((lineno, "lui", [args[0], str(value >> 16)]))
+            elif op in OPCODE:
+                insns.append((lineno, op, args))
+            else:
+                raise AsmError(f"unknown instruction '{op}'")
+        except (AsmError, IndexError, ValueError) as e:
+            raise AsmError(f"{path}:{lineno}: {e}")
+    return symbols, labels, insns
+
+
+def encode(op, args, symbols, labels):
+    form = FORMS[op].split()
+    if len(args) != len(form):
+        raise AsmError(f"'{op}' takes {len(form)} operands")
+    word = OPCODE[op] << 24
+    reg_shifts = list(REG_FIELDS.get(op, (20, 16, 12)))
+    for kind, arg in zip(form, args):
+        if kind == "r":
+            word |= parse_reg(arg) << reg_shifts.pop(0)
+        elif kind == "i16":
+            value = parse_int(arg, symbols)
+            if not -0x8000 <= value <= 0xFFFF:
+                raise AsmError(f"{value} does not fit in 16 bits")
+            word |= value & 0xFFFF
+        elif kind == "s12":
+            value = parse_int(arg, symbols)
+            if not -0x800 <= value <= 0x7FF:
+                raise AsmError(f"{value} does not fit in signed 12 bits")
+            word |= value & 0xFFF
+        elif kind == "i12":
+            value = parse_int(arg, symbols)
+            if not 0 <= value <= 31:
+                raise AsmError(f"shift {value} out of range")
+            word |= value
+        elif kind == "m":
+            value = parse_int(arg.strip("[] "), symbols)
+            if not 0 <= value < MEM_WORDS:
+                raise AsmError(f"memory address {value} out of range")
+            word |= value
+        elif kind == "l":
+            if arg not in labels:
+                raise AsmError(f"unknown label '{arg}'")
+            word |= labels[arg]
+    return word
+
+
+def assemble(path):
+    symbols, labels, insns = first_pass(path)
+    if not insns:
+        raise AsmError(f"{path}: no instructions")
+    if len(insns) > CODE_WORDS:
+        raise AsmError(f"{path}: {len(insns)} instructions, limit is {CODE_WORDS}")
+    if insns[-1][1] not in ("end", "jmp"):
+        raise AsmError(f"{path}: last instruction must be end or jmp")
+    code = []
+    for lineno, op, args in insns:
+        try:
+            code.append(encode(op, args, symbols, labels))
+        except AsmError as e:
+            raise AsmError(f"{path}:{lineno}: {e}")
+    return [MAGIC, len(code)] + code
+
+
+def c_name(path):
+    return "fx_" + re.sub(r"\W", "_", os.path.splitext(os.path.basename(path))[0])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--format", choices=("header", "bin", "hex"), default="header")
+    parser.add_argument("-o", "--output", required=True)
+    parser.add_argument("inputs", nargs="+")
+    args = parser.parse_args()
+
+    try:
+        images = [(path, assemble(path)) for path in args.inputs]
+    except AsmError as e:
+        sys.exit(str(e))
+
+    if args.format == "bin":
+        if len(images) != 1:
+            sys.exit("bin output takes one script")
+        with open(args.output, "wb") as f:
+            f.write(struct.pack(f"<{len(images[0][1])}I", *images[0][1]))
+        return
+
+    if args.format == "hex":
+        with open(args.output, "w", encoding="ascii") as f:
+            for path, image in images:
+                f.write("FX " + " ".join(f"{w:08x}" for w in image) + "\n")
+        return
+
+    out = [
+        "// Generated by fxasm.py, do not edit",
+        "#pragma once",
+        "",
+    ]
+    for path, image in images:
+        out.append(f"// {os.path.basename(path)}, {image[1]} instructions")
+        out.append(f"static const uint32_t {c_name(path)}[{len(image)}] = {{")
+        for j in range(0, len(image), 6):
+            out.append("    " + " ".join(f"0x{w:08x}," for w in image[j:j + 6]))
+        out.append("};")
+        out.append("")
+    with open(args.output, "w", encoding="ascii") as f:
+        f.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()
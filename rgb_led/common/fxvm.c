@@ -0,0 +1,213 @@
+/**
+ * @brief Bytecode VM for LED effect scripts
+ *
+ * A script is run once per pixel per frame on sixteen 32-bit registers
+ * and a small persistent memory, and ends each pixel with END after
+ * setting the pixel with RGB or HSV. Images are checked once when loaded,
+ * opcodes, jump targets and memory addresses, so the interpreter loop does
+ * no bounds checks. The one run-time limit is the frame's instruction
+ * budget, FXVM_PIXEL_STEPS per pixel shared across the frame, which stops
+ * a runaway loop from stalling the strip. See fxasm.py for the assembler.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include <string.h>
+
+#include "fxvm.h"
+
+/* Globals */
+static const uint8_t fxvm_sin[256] = {
+    128, 131, 134, 137, 140, 144, 147, 150, 153, 156, 159, 162, 165, 168, 171, 174,
+    177, 179, 182, 185, 188, 191, 193, 196, 199, 201, 204, 206, 209, 211, 213, 216,
+    218, 220, 222, 224, 226, 228, 230, 232, 234, 235, 237, 239, 240, 241, 243, 244,
+    245, 246, 248, 249, 250, 250, 251, 252, 253, 253, 254, 254, 254, 255, 255, 255,
+    255, 255, 255, 255, 254, 254, 254, 253, 253, 252, 251, 250, 250, 249, 248, 246,
+    245, 244, 243, 241, 240, 239, 237, 235, 234, 232, 230, 228, 226, 224, 222, 220,
+    218, 216, 213, 211, 209, 206, 204, 201, 199, 196, 193, 191, 188, 185, 182, 179,
+    177, 174, 171, 168, 165, 162, 159, 156, 153, 150, 147, 144, 140, 137, 134, 131,
+    128, 125, 122, 119, 116, 112, 109, 106, 103, 100,  97,  94,  91,  88,  85,  82,
+     79,  77,  74,  71,  68,  65,  63,  60,  57,  55,  52,  50,  47,  45,  43,  40,
+     38,  36,  34,  32,  30,  28,  26,  24,  22,  21,  19,  17,  16,  15,  13,  12,
+     11,  10,   8,   7,   6,   6,   5,   4,   3,   3,   2,   2,   2,   1,   1,   1,
+      1,   1,   1,   1,   2,   2,   2,   3,   3,   4,   5,   6,   6,   7,   8,  10,
+     11,  12,  13,  15,  16,  17,  19,  21,  22,  24,  26,  28,  30,  32,  34,  36,
+     38,  40,  43,  45,  47,  50,  52,  55,  57,  60,  63,  65,  68,  71,  74,  77,
+     79,  82,  85,  88,  91,  94,  97, 100, 103, 106, 109, 112, 116, 119, 122, 125,
+};
+
+/* Code */
+static inline uint8_t fxvm_clamp(int32_t x) {
+    return x < 0 ? 0 : x > 255 ? 255 : x;
+}
+
+static inline int32_t fxvm_sext(uint32_t x, unsigned bits) {
+    return (int32_t) (x << (32 - bits)) >> (32 - bits);
+}
+
+// Image is the magic, the code length, then the code. Registers, memory
+// and the random seed are reset.
+int fxvm_load(fxvm_t *vm, const uint32_t *image, size_t words) {
+    if (words < 2 || image[0] != FXVM_MAGIC) {
+        return FXVM_ERR_MAGIC;
+    }
+    uint32_t len = image[1];
+    if (len == 0 || len > FXVM_CODE_WORDS || len != words - 2) {
+        return FXVM_ERR_SIZE;
+    }
+
+    for (uint32_t pc = 0; pc < len; pc++) {
+        uint32_t w = image[2 + pc];
+        unsigned op = FXVM_OP(w);
+
+        if (op >= FXVM_NUM_OPS) {
+            return FXVM_ERR_OP;
+        }
+        if ((op == FXVM_JMP || op == FXVM_JZ || op == FXVM_JNZ || op == FXVM_JLT)
+            && FXVM_IMM12(w) >= len) {
+            return FXVM_ERR_JUMP;
+        }
+        if ((op == FXVM_LD || op == FXVM_ST) && FXVM_IMM12(w) >= FXVM_MEM_WORDS) {
+            return FXVM_ERR_MEM;
+        }
+    }
+    // Running off the end must not be possible either
+    unsigned last = FXVM_OP(image[1 + len]);
+    if (last != FXVM_END && last != FXVM_JMP) {
+        return FXVM_ERR_JUMP;
+    }
+
+    memcpy(vm->code, &image[2], len * sizeof(uint32_t));
+    vm->len = len;
+    memset(vm->regs, 0, sizeof(vm->regs));
+    memset(vm->mem, 0, sizeof(vm->mem));
+    vm->rng = 0x2545F491;
+    vm->steps = 0;
+    return FXVM_OK;
+}
+
+// Runs the script for every pixel. Out of budget, the rest of the pixels
+// keep their old colors and FXVM_ERR_BUDGET is returned.
+int fxvm_frame(fxvm_t *vm, rgb_t *pixels, size_t n, uint32_t frame) {
+    const uint32_t *code = vm->code;
+    int32_t *r = vm->regs;
+    int32_t budget = n * FXVM_PIXEL_STEPS;
+
+    for (size_t i = 0; i < n; i++) {
+        uint32_t pc = 0;
+
+        r[FXVM_R_INDEX] = i;
+        r[FXVM_R_FRAME] = frame;
+        r[FXVM_R_COUNT] = n;
+
+        for (;;) {
+            uint32_t w = code[pc++];
+
+            if (--budget < 0) {
+                vm->steps = n * FXVM_PIXEL_STEPS;
+                return FXVM_ERR_BUDGET;
+            }
+
+            switch (FXVM_OP(w)) {
+                case FXVM_END:
+                    goto next_pixel;
+                case FXVM_LDI:
+                    r[FXVM_D(w)] = (int16_t) FXVM_IMM16(w);
+                    break;
+                case FXVM_LUI:
+                    r[FXVM_D(w)] = (r[FXVM_D(w)] & 0xFFFF) | (FXVM_IMM16(w) << 16);
+                    break;
+                case FXVM_MOV:
+                    r[FXVM_D(w)] = r[FXVM_A(w)];
+                    break;
+                // Unsigned, so overflow wraps rather than being undefined
+                case FXVM_ADD:
+                    r[FXVM_D(w)] = (uint32_t) r[FXVM_A(w)] + (uint32_t) r[FXVM_B(w)];
+                    break;
+                case FXVM_SUB:
+                    r[FXVM_D(w)] = (uint32_t) r[FXVM_A(w)] - (uint32_t) r[FXVM_B(w)];
+                    break;
+                case FXVM_MUL:
+                    r[FXVM_D(w)] = (uint32_t) r[FXVM_A(w)] * (uint32_t) r[FXVM_B(w)];
+                    break;
+                case FXVM_MULQ:
+                    r[FXVM_D(w)] = ((int64_t) r[FXVM_A(w)] * r[FXVM_B(w)]) >> 8;
+                    break;
+                case FXVM_ADDI:
+                    r[FXVM_D(w)] = (uint32_t) r[FXVM_A(w)] + fxvm_sext(FXVM_IMM12(w), 12);
+                    break;
+                case FXVM_SHL:
+                    r[FXVM_D(w)] = (uint32_t) r[FXVM_A(w)] << (FXVM_IMM12(w) & 31);
+                    break;
+                case FXVM_SHR:
+                    r[FXVM_D(w)] = r[FXVM_A(w)] >> (FXVM_IMM12(w) & 31);
+                    break;
+                case FXVM_AND:
+                    r[FXVM_D(w)] = r[FXVM_A(w)] & r[FXVM_B(w)];
+                    break;
+                case FXVM_OR:
+                    r[FXVM_D(w)] = r[FXVM_A(w)] | r[FXVM_B(w)];
+                    break;
+                case FXVM_XOR:
+                    r[FXVM_D(w)] = r[FXVM_A(w)] ^ r[FXVM_B(w)];
+                    break;
+                case FXVM_MIN:
+                    r[FXVM_D(w)] = r[FXVM_A(w)] < r[FXVM_B(w)] ? r[FXVM_A(w)] : r[FXVM_B(w)];
+                    break;
+                case FXVM_MAX:
+                    r[FXVM_D(w)] = r[FXVM_A(w)] > r[FXVM_B(w)] ? r[FXVM_A(w)] : r[FXVM_B(w)];
+                    break;
+                case FXVM_SIN:
+                    r[FXVM_D(w)] = fxvm_sin[r[FXVM_A(w)] & 0xFF];
+                    break;
+                case FXVM_RND:
+                    vm->rng ^= vm->rng << 13;
+                    vm->rng ^= vm->rng >> 17;
+                    vm->rng ^= vm->rng << 5;
+                    r[FXVM_D(w)] = vm->rng >> 16;
+                    break;
+                case FXVM_LD:
+                    r[FXVM_D(w)] = vm->mem[FXVM_IMM12(w)];
+                    break;
+                case FXVM_ST:
+                    vm->mem[FXVM_IMM12(w)] = r[FXVM_D(w)];
+                    break;
+                case FXVM_JMP:
+                    pc = FXVM_IMM12(w);
+                    break;
+                case FXVM_JZ:
+                    if (r[FXVM_A(w)] == 0) {
+                        pc = FXVM_IMM12(w);
+                    }
+                    break;
+                case FXVM_JNZ:
+                    if (r[FXVM_A(w)] != 0) {
+                        pc = FXVM_IMM12(w);
+                    }
+                    break;
+                case FXVM_JLT:
+                    if (r[FXVM_A(w)] < r[FXVM_B(w)]) {
+                        pc = FXVM_IMM12(w);
+                    }
+                    break;
+                case FXVM_RGB:
+                    pixels[i] = (rgb_t) {
+                        fxvm_clamp(r[FXVM_D(w)]), fxvm_clamp(r[FXVM_A(w)]), fxvm_clamp(r[FXVM_B(w)])
+                    };
+                    break;
+                case FXVM_HSV:
+                    pixels[i] = rgb_from_hsv((hsv_t) {
+                        r[FXVM_D(w)], fxvm_clamp(r[FXVM_A(w)]), fxvm_clamp(r[FXVM_B(w)])
+                    });
+                    break;
+            }
+        }
+next_pixel:
+        ;
+    }
+    vm->steps = n * FXVM_PIXEL_STEPS - budget;
+    return FXVM_OK;
+}
@@ -0,0 +1,91 @@
+/**
+ * @brief Bytecode VM for LED effect scripts
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rgb_color.h"
+
+#define FXVM_MAGIC          0x31565846u     // "FXV1"
+#define FXVM_REGS           16
+#define FXVM_MEM_WORDS      64
+#define FXVM_CODE_WORDS     256
+
+// CPU budget, instructions per pixel per frame on average. 1000 pixels at
+// 30 fps is 1.92 M instructions/s.
+#define FXVM_PIXEL_STEPS    64
+
+// Instruction word: op [31:24], d [23:20], a [19:16], b [15:12], imm12
+// [11:0], or imm16 [15:0] for LDI and LUI
+#define FXVM_OP(w)          ((w) >> 24)
+#define FXVM_D(w)           (((w) >> 20) & 0xF)
+#define FXVM_A(w)           (((w) >> 16) & 0xF)
+#define FXVM_B(w)           (((w) >> 12) & 0xF)
+#define FXVM_IMM12(w)       ((w) & 0xFFF)
+#define FXVM_IMM16(w)       ((w) & 0xFFFF)
+
+// Registers set before each pixel, the rest carry over
+#define FXVM_R_INDEX        0
+#define FXVM_R_FRAME        1
+#define FXVM_R_COUNT        2
+
+// Registers are 32-bit signed, arithmetic wraps
+enum fxvm_op {
+    FXVM_END,       // Pixel done
+    FXVM_LDI,       // d = sign extended imm16
+    FXVM_LUI,       // d = low half of d | imm16 << 16
+    FXVM_MOV,       // d = a
+    FXVM_ADD,       // d = a + b
+    FXVM_SUB,       // d = a - b
+    FXVM_MUL,       // d = a * b
+    FXVM_MULQ,      // d = (a * b) >> 8, product in 64 bits
+    FXVM_ADDI,      // d = a + sign extended imm12
+    FXVM_SHL,       // d = a << imm12
+    FXVM_SHR,       // d = a >> imm12, arithmetic
+    FXVM_AND,       // d = a & b
+    FXVM_OR,        // d = a | b
+    FXVM_XOR,       // d = a ^ b
+    FXVM_MIN,       // d = min(a, b)
+    FXVM_MAX,       // d = max(a, b)
+    FXVM_SIN,       // d = 128 + 127 sin(a / 256 turn), a mod 256
+    FXVM_RND,       // d = next random, 0 to 65535
+    FXVM_LD,        // d = mem[imm12]
+    FXVM_ST,        // mem[imm12] = d
+    FXVM_JMP,       // pc = imm12
+    FXVM_JZ,        // if a == 0, pc = imm12
+    FXVM_JNZ,       // if a != 0, pc = imm12
+    FXVM_JLT,       // if a < b, pc = imm12
+    FXVM_RGB,       // pixel = d, a, b clamped to 0 to 255
+    FXVM_HSV,       // pixel = HSV of hue d (16 bit), saturation a, value b
+    FXVM_NUM_OPS
+};
+
+enum fxvm_status {
+    FXVM_OK = 0,
+    FXVM_ERR_MAGIC = -1,
+    FXVM_ERR_SIZE = -2,
+    FXVM_ERR_OP = -3,
+    FXVM_ERR_JUMP = -4,
+    FXVM_ERR_MEM = -5,
+    FXVM_ERR_BUDGET = -6,
+};
+
+// All state is in here, no allocation after load
+typedef struct {
+    uint32_t code[FXVM_CODE_WORDS];
+    uint32_t len;
+    int32_t regs[FXVM_REGS];
+    int32_t mem[FXVM_MEM_WORDS];
+    uint32_t rng;
+
+    uint32_t steps;         // Instructions run by the last frame
+} fxvm_t;
+
+int fxvm_load(fxvm_t *vm, const uint32_t *image, size_t words);
+int fxvm_frame(fxvm_t *vm, rgb_t *pixels, size_t n, uint32_t frame);
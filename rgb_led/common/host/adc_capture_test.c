@@ -0,0 +1,193 @@
+/**
+ * @brief Host test of the ADC capture ring's block and overrun accounting
+ *
+ * Runs adc_capture.c unmodified against the DMA and ADC models in
+ * sdk_model. Each conversion is the next value of a counter, so every
+ * block handed out can be checked sample by sample against the block
+ * number it should be. Covers blocks taken as they come, the interrupt
+ * held off for several blocks and taken mid-block, a consumer falling
+ * behind while the DMA runs ahead of the interrupt, and a stop and
+ * restart with the model firing chains on abort.
+ *
+ *     cc -O2 -I.. -Isdk_model -o adc_capture_test adc_capture_test.c ../adc_capture.c ../adc_rate.c && ./adc_capture_test
+ *
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Defines */
+#define BLOCK_LEN       64
+#define NUM_BLOCKS      8
+#define RING_BYTES      (BLOCK_LEN * NUM_BLOCKS * sizeof(uint16_t))
+
+/* Includes */
+#include <stdio.h>
+
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+#include "adc_capture.h"
+
+/* Globals */
+adc_model_t adc_model;
+dma_model_t dma_model;
+irq_handler_t irq_model_handlers[IRQ_MODEL_NUM];
+uint32_t task_model_notifies;
+uint64_t time_model_us;
+
+static uint16_t ring[NUM_BLOCKS * BLOCK_LEN] __attribute__((aligned(RING_BYTES)));
+static int fails;
+
+// Counter value of the first sample since the last start
+static uint16_t first_sample;
+
+/* Code */
+static void expect(const char *what, long got, long want) {
+    if (got != want) {
+        printf("FAIL %s: got %ld, want %ld\n", what, got, want);
+        fails++;
+    }
+}
+
+static void take_irq(void) {
+    irq_model_handlers[DMA_IRQ_1]();
+}
+
+static void start(void) {
+    first_sample = adc_model.next;
+    adc_capture_start();
+}
+
+// The next block from adc_capture_block() must be block n since start
+static void expect_block(const char *what, uint32_t n) {
+    const uint16_t *block = adc_capture_block();
+
+    if (!block) {
+        printf("FAIL %s: no block %u\n", what, n);
+        fails++;
+        return;
+    }
+    for (uint i = 0; i < BLOCK_LEN; i++) {
+        uint16_t want = first_sample + n * BLOCK_LEN + i;
+        if (block[i] != want) {
+            printf("FAIL %s: block %u sample %u is %u, want %u\n", what, n, i, block[i], want);
+            fails++;
+            return;
+        }
+    }
+}
+
+static void expect_none(const char *what) {
+    expect(what, adc_capture_block() != NULL, 0);
+}
+
+// Blocks taken as each interrupt comes in
+static void test_in_order(void) {
+    start();
+    for (uint32_t n = 0; n < 3 * NUM_BLOCKS; n++) {
+        adc_model_convert(BLOCK_LEN);
+        take_irq();
+        expect_block("in order", n);
+        expect_none("in order, caught up");
+    }
+    expect("in order blocks", adc_capture_stats.blocks, 3 * NUM_BLOCKS);
+    expect("in order overruns", adc_capture_stats.overruns, 0);
+    adc_capture_stop();
+}
+
+// One interrupt for several blocks counts them all, and one taken
+// partway into the next block does not count that one
+static void test_late_irq(void) {
+    uint32_t blocks = adc_capture_stats.blocks;
+
+    start();
+    adc_model_convert(3 * BLOCK_LEN + BLOCK_LEN / 2);
+    take_irq();
+    expect("late irq blocks", adc_capture_stats.blocks - blocks, 3);
+    for (uint32_t n = 0; n < 3; n++) {
+        expect_block("late irq", n);
+    }
+    expect_none("late irq, caught up");
+
+    // num_blocks - 1 is as late as it can be and still count them all,
+    // and the oldest of those has been overwritten by then
+    uint32_t overruns = adc_capture_stats.overruns;
+    adc_model_convert(BLOCK_LEN / 2 + (NUM_BLOCKS - 2) * BLOCK_LEN);
+    take_irq();
+    expect("late irq, most of a ring", adc_capture_stats.blocks - blocks, 3 + NUM_BLOCKS - 1);
+    for (uint32_t n = 4; n < 3 + NUM_BLOCKS - 1; n++) {
+        expect_block("late irq, most of a ring", n);
+    }
+    expect_none("late irq, most of a ring, caught up");
+    expect("late irq overruns", adc_capture_stats.overruns - overruns, 1);
+    adc_capture_stop();
+}
+
+// A consumer more than num_blocks - 2 behind skips to the oldest block
+// still intact, even with the DMA a block and a half past the interrupt
+static void test_overrun(void) {
+    const uint32_t behind = NUM_BLOCKS + 5;
+    uint32_t overruns = adc_capture_stats.overruns;
+
+    start();
+    for (uint32_t n = 0; n < behind; n++) {
+        adc_model_convert(BLOCK_LEN);
+        take_irq();
+    }
+    adc_model_convert(BLOCK_LEN + BLOCK_LEN / 2);
+
+    uint32_t oldest = behind - (NUM_BLOCKS - 2);
+    for (uint32_t n = oldest; n < behind; n++) {
+        expect_block("overrun", n);
+    }
+    expect("overrun count", adc_capture_stats.overruns - overruns, oldest);
+
+    take_irq();
+    expect_block("overrun, after the irq", behind);
+    expect_none("overrun, caught up");
+    adc_capture_stop();
+}
+
+// Stopping leaves nothing running even though abort fires chains, and a
+// restart begins again at the first block
+static void test_stop(void) {
+    uint32_t chain_triggers = dma_model.chain_triggers;
+
+    start();
+    adc_model_convert(BLOCK_LEN / 2);
+    adc_capture_stop();
+    expect("stop, chains fired", dma_model.chain_triggers - chain_triggers, 0);
+    expect("stop, channels busy", dma_model_any_busy(), 0);
+
+    uint16_t before = ring[BLOCK_LEN / 2];
+    adc_model_convert(BLOCK_LEN);
+    expect("stop, ring untouched", ring[BLOCK_LEN / 2], before);
+    expect_none("stop");
+
+    start();
+    for (uint32_t n = 0; n < 2; n++) {
+        adc_model_convert(BLOCK_LEN);
+        take_irq();
+        expect_block("restart", n);
+    }
+    adc_capture_stop();
+}
+
+int main(void) {
+    int dummy_task;
+
+    adc_capture_init(&dummy_task, 0, 100000, ring, BLOCK_LEN, NUM_BLOCKS);
+
+    test_in_order();
+    test_late_irq();
+    test_overrun();
+    test_stop();
+
+    expect("notifications", task_model_notifies > 0, 1);
+    expect("FIFO overflow", (adc_model.hw.fcs & ADC_FCS_OVER_BITS) != 0, 0);
+    printf("%u blocks, %u overruns, %d failures\n", adc_capture_stats.blocks,
+           adc_capture_stats.overruns, fails);
+    return fails != 0;
+}
@@ -0,0 +1,130 @@
+/**
+ * @brief Host check and benchmark for the fixed-point ADC filters
+ *
+ * Feeds a synthetic pot reading, slow sweeps with Gaussian noise and the
+ * odd full-scale spike, through adc_filter.c and the float reference with
+ * the same settings. Compares the filtered values at every decimated
+ * output, counts the change events each reports and times both. Where a
+ * value sits on the zero threshold the two can round to opposite sides
+ * of it, those are counted apart from the error.
+ *
+ *     cc -O2 -I.. -o adc_filter_bench adc_filter_bench.c ../adc_filter.c -lm && ./adc_filter_bench
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Defines */
+#define NUM_SAMPLES     (1 << 22)
+#define BLOCK_LEN       1024
+#define NOISE_LSB       6.0     // Standard deviation, 12-bit LSB
+#define SPIKE_EVERY     997
+
+/* Includes */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "adc_filter.h"
+#include "adc_filter_ref.h"
+
+/* Globals */
+static const struct {
+    const char *name;
+    adc_filter_config_t cfg;
+} configs[] = {
+    { "raw",               { 0, 0, 0, 0, 0 } },
+    { "decimate 16",       { 4, 0, 0, 0, 0 } },
+    { "median 5",          { 0, 5, 0, 0, 0 } },
+    { "iir 1/16",          { 0, 0, 4, 0, 0 } },
+    { "pot, 100 ksps",     { 6, 5, 2, 96, 480 } },
+    { "everything, dense", { 2, 9, 5, 64, 480 } },
+};
+
+static uint16_t samples[NUM_SAMPLES];
+
+/* Code */
+static double now_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double gauss(void) {
+    double u = (rand() + 1.0) / (RAND_MAX + 2.0);
+    double v = (rand() + 1.0) / (RAND_MAX + 2.0);
+
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+int main(void) {
+    int failed = 0;
+
+    srand(1);
+    for (uint32_t i = 0; i < NUM_SAMPLES; i++) {
+        double x = 2048.0 + 2100.0 * sin(i * 2.0 * M_PI / (1 << 20)) + NOISE_LSB * gauss();
+
+        if (i % SPIKE_EVERY == 0) {
+            x = 4095;
+        }
+        samples[i] = x < 0 ? 0 : x > 4095 ? 4095 : (uint16_t) lrint(x);
+    }
+
+    printf("%-18s %8s %9s %6s %8s %8s %10s %10s\n", "config", "max err", "mean err",
+           "snaps", "events", "ref ev", "fixed M/s", "float M/s");
+
+    for (unsigned c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        const adc_filter_config_t *cfg = &configs[c].cfg;
+        uint32_t per = 1u << cfg->decimate_shift;
+        adc_filter_t f;
+        adc_filter_ref_t ref;
+        uint16_t out = 0;
+        float ref_out = 0;
+        uint32_t events = 0, ref_events = 0, n = 0, snaps = 0;
+        double max_err = 0, sum_err = 0;
+
+        // Accuracy, a decimated output at a time so the values line up
+        adc_filter_init(&f, cfg);
+        adc_filter_ref_init(&ref, cfg);
+        for (uint32_t i = 0; i < NUM_SAMPLES; i += per) {
+            events += adc_filter_block(&f, &samples[i], per, &out);
+            for (uint32_t j = 0; j < per; j++) {
+                ref_events += adc_filter_ref_sample(&ref, samples[i + j], &ref_out);
+            }
+
+            if (cfg->zero && (f.value == 0) != (ref.value == 0)) {
+                snaps++;
+                continue;
+            }
+            double e = fabs(f.value - ref.value);
+            max_err = e > max_err ? e : max_err;
+            sum_err += e;
+            n++;
+        }
+
+        // Throughput, in blocks the way the capture hands them out
+        volatile uint32_t sink = 0;
+        double t0 = now_s();
+        adc_filter_init(&f, cfg);
+        for (uint32_t i = 0; i < NUM_SAMPLES; i += BLOCK_LEN) {
+            sink += adc_filter_block(&f, &samples[i], BLOCK_LEN, &out);
+        }
+        double t1 = now_s();
+        adc_filter_ref_init(&ref, cfg);
+        for (uint32_t i = 0; i < NUM_SAMPLES; i++) {
+            sink += adc_filter_ref_sample(&ref, samples[i], &ref_out);
+        }
+        double t2 = now_s();
+
+        printf("%-18s %8.2f %9.3f %6u %8u %8u %10.1f %10.1f\n", configs[c].name, max_err,
+               sum_err / n, snaps, events, ref_events, NUM_SAMPLES / (t1 - t0) / 1e6,
+               NUM_SAMPLES / (t2 - t1) / 1e6);
+
+        // Errors in 16-bit LSB, the 12-bit input is 16 of them
+        failed |= max_err > 16;
+    }
+    return failed;
+}
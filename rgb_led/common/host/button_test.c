@@ -0,0 +1,188 @@
+/**
+ * @brief Host test of the button debounce and its state resync
+ *
+ * Runs button.c unmodified against the GPIO model in sdk_model, with the
+ * edge interrupt taken as soon as the model pin changes and the ring
+ * drained after each step. Covers a clean press and release, press and
+ * release bounces, a tap shorter than the debounce time followed by a
+ * real press, both edges in one interrupt, a button held at startup and
+ * a handler added for presses only.
+ *
+ *     cc -O2 -I.. -Isdk_model -o button_test button_test.c ../button.c && ./button_test
+ *
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Defines */
+#define PIN             2
+#define PRESS_ONLY_PIN  3
+#define HELD_PIN        4
+#define DEBOUNCE_US     5000
+#define MAX_EVENTS      16
+
+/* Includes */
+#include <stdio.h>
+
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+#include "button.h"
+
+/* Globals */
+gpio_model_t gpio_model;
+irq_handler_t irq_model_handlers[IRQ_MODEL_NUM];
+uint32_t task_model_notifies;
+uint64_t time_model_us;
+
+typedef struct {
+    uint gpio;
+    button_event_t event;
+    uint64_t time_us;
+} event_t;
+
+static event_t events[MAX_EVENTS];
+static uint num_events;
+static int fails;
+
+/* Code */
+static void expect(const char *what, long got, long want) {
+    if (got != want) {
+        printf("FAIL %s: got %ld, want %ld\n", what, got, want);
+        fails++;
+    }
+}
+
+static void handler(uint gpio, button_event_t event, uint64_t time_us) {
+    if (num_events < MAX_EVENTS) {
+        events[num_events++] = (event_t) { gpio, event, time_us };
+    }
+}
+
+// Pin goes to level at time_us, then the task takes the ring
+static void edge_at(uint gpio, uint64_t time_us, bool level) {
+    time_model_us = time_us;
+    gpio_model_set(gpio, level);
+    button_dispatch();
+}
+
+// The handler saw exactly these, in order, since the last call
+static void expect_events(const char *what, const event_t *want, uint n) {
+    expect(what, num_events, n);
+    for (uint i = 0; i < n && i < num_events; i++) {
+        if (events[i].gpio != want[i].gpio || events[i].event != want[i].event
+            || events[i].time_us != want[i].time_us) {
+            printf("FAIL %s: event %u is gpio %u %s at %llu, want gpio %u %s at %llu\n", what, i,
+                   events[i].gpio, events[i].event == BUTTON_PRESS ? "press" : "release",
+                   (unsigned long long) events[i].time_us, want[i].gpio,
+                   want[i].event == BUTTON_PRESS ? "press" : "release",
+                   (unsigned long long) want[i].time_us);
+            fails++;
+        }
+    }
+    num_events = 0;
+}
+
+// Press and release with bounces on each, only the first of each is seen
+static void test_bounce(uint64_t t) {
+    uint32_t bounces = button_stats.bounces;
+
+    edge_at(PIN, t, 0);
+    edge_at(PIN, t + 100, 1);
+    edge_at(PIN, t + 200, 0);
+    edge_at(PIN, t + 100000, 1);
+    edge_at(PIN, t + 100300, 0);
+    edge_at(PIN, t + 100400, 1);
+    expect_events("bounce", (event_t[]) {
+        { PIN, BUTTON_PRESS, t }, { PIN, BUTTON_RELEASE, t + 100000 }
+    }, 2);
+    expect("bounce count", button_stats.bounces - bounces, 4);
+}
+
+// A tap shorter than the debounce time loses its release, the next press
+// still counts and the release is reported first at its own time
+static void test_short_tap(uint64_t t) {
+    uint32_t resyncs = button_stats.resyncs;
+
+    edge_at(PIN, t, 0);
+    edge_at(PIN, t + 2000, 1);
+    expect_events("short tap", (event_t[]) { { PIN, BUTTON_PRESS, t } }, 1);
+
+    edge_at(PIN, t + 500000, 0);
+    edge_at(PIN, t + 600000, 1);
+    expect_events("press after a short tap", (event_t[]) {
+        { PIN, BUTTON_RELEASE, t + 2000 }, { PIN, BUTTON_PRESS, t + 500000 },
+        { PIN, BUTTON_RELEASE, t + 600000 }
+    }, 3);
+    expect("short tap resyncs", button_stats.resyncs - resyncs, 1);
+}
+
+// Both edges in one interrupt go by the level the pin is left at
+static void test_both_edges(uint64_t t) {
+    uint32_t fall_rise = GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE;
+
+    // A glitch that ends where it started is a bounce
+    time_model_us = t;
+    gpio_model_edges(PIN, fall_rise, 1);
+    button_dispatch();
+    expect_events("glitch", NULL, 0);
+
+    // One that ends pressed is a press
+    time_model_us = t + 100000;
+    gpio_model_edges(PIN, fall_rise, 0);
+    button_dispatch();
+    edge_at(PIN, t + 200000, 1);
+    expect_events("both edges", (event_t[]) {
+        { PIN, BUTTON_PRESS, t + 100000 }, { PIN, BUTTON_RELEASE, t + 200000 }
+    }, 2);
+}
+
+// A handler added for presses never sees releases, even resynced ones
+static void test_press_only(uint64_t t) {
+    edge_at(PRESS_ONLY_PIN, t, 0);
+    edge_at(PRESS_ONLY_PIN, t + 1000, 1);
+    edge_at(PRESS_ONLY_PIN, t + 100000, 0);
+    edge_at(PRESS_ONLY_PIN, t + 200000, 1);
+    expect_events("press only", (event_t[]) {
+        { PRESS_ONLY_PIN, BUTTON_PRESS, t }, { PRESS_ONLY_PIN, BUTTON_PRESS, t + 100000 }
+    }, 2);
+}
+
+// Held at startup, its release is the first edge
+static void test_held(uint64_t t) {
+    uint32_t resyncs = button_stats.resyncs;
+
+    edge_at(HELD_PIN, t, 1);
+    edge_at(HELD_PIN, t + 100000, 0);
+    expect_events("held at startup", (event_t[]) {
+        { HELD_PIN, BUTTON_RELEASE, t }, { HELD_PIN, BUTTON_PRESS, t + 100000 }
+    }, 2);
+    expect("held, no resync", button_stats.resyncs - resyncs, 0);
+}
+
+int main(void) {
+    int dummy_task;
+
+    gpio_model.level[PIN] = 1;
+    gpio_model.level[PRESS_ONLY_PIN] = 1;
+    gpio_model.level[HELD_PIN] = 0;
+    time_model_us = 1000000;
+
+    button_init(&dummy_task, 0x40);
+    button_add(PIN, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, DEBOUNCE_US, handler);
+    button_add(PRESS_ONLY_PIN, GPIO_IRQ_EDGE_FALL, DEBOUNCE_US, handler);
+    button_add(HELD_PIN, GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, DEBOUNCE_US, handler);
+
+    test_bounce(2000000);
+    test_short_tap(3000000);
+    test_both_edges(4000000);
+    test_press_only(5000000);
+    test_held(6000000);
+
+    expect("notifications", task_model_notifies, button_stats.edges);
+    expect("dropped", button_stats.dropped, 0);
+    printf("%u edges, %u bounces, %u resyncs, %d failures\n", button_stats.edges,
+           button_stats.bounces, button_stats.resyncs, fails);
+    return fails != 0;
+}
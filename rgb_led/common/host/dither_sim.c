@@ -0,0 +1,84 @@
+/**
+ * @brief Host simulation of the dithered PWM output
+ *
+ * Runs every 16-bit level through dither_pattern() and a model of the PWM
+ * counter, which is high while the count is below the compare value, and
+ * measures the delivered duty against level / 65536. Errors are in 16-bit
+ * level units. Plain truncation to the short wrap is shown for contrast.
+ *
+ *     cc -O2 -I.. -o dither_sim dither_sim.c ../dither.c -lm && ./dither_sim
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Defines */
+#define SYS_CLK_HZ      125000000.0
+#define WINDOW          3       // Short window for ripple, in periods
+#define LONG_RUN        1000    // Periods, not a whole number of patterns
+
+/* Includes */
+#include <math.h>
+#include <stdio.h>
+
+#include "dither.h"
+
+/* Code */
+// High counts in one period of the counter
+static unsigned pwm_period(unsigned cc) {
+    return cc > DITHER_TOP + 1 ? DITHER_TOP + 1 : cc;
+}
+
+// Delivered level over n periods of the looping pattern
+static double delivered(const uint16_t *cc, unsigned start, unsigned n) {
+    double high = 0;
+
+    for (unsigned i = 0; i < n; i++) {
+        high += pwm_period(cc[(start + i) % DITHER_STEPS]);
+    }
+    return high / (n * (DITHER_TOP + 1.0)) * 65536.0;
+}
+
+int main(void) {
+    uint16_t cc[DITHER_STEPS];
+    double sum_pass = 0, max_pass = 0;
+    double sum_long = 0, max_long = 0;
+    double max_window = 0;
+    double sum_trunc = 0, max_trunc = 0;
+    unsigned bad_range = 0;
+
+    for (unsigned level = 0; level < 65536; level++) {
+        dither_pattern(cc, level);
+
+        for (unsigned i = 0; i < DITHER_STEPS; i++) {
+            bad_range += cc[i] > DITHER_TOP + 1;
+        }
+
+        double e = fabs(delivered(cc, 0, DITHER_STEPS) - level);
+        sum_pass += e;
+        max_pass = fmax(max_pass, e);
+
+        e = fabs(delivered(cc, 0, LONG_RUN) - level);
+        sum_long += e;
+        max_long = fmax(max_long, e);
+
+        for (unsigned s = 0; s < DITHER_STEPS; s++) {
+            max_window = fmax(max_window, fabs(delivered(cc, s, WINDOW) - level));
+        }
+
+        e = fabs((double) ((level >> DITHER_FRAC_BITS) << DITHER_FRAC_BITS) - level);
+        sum_trunc += e;
+        max_trunc = fmax(max_trunc, e);
+    }
+
+    printf("pwm %.1f kHz, wrap %u, pattern %u periods (%.2f kHz)\n",
+           SYS_CLK_HZ / (DITHER_TOP + 1) / 1000, DITHER_TOP, DITHER_STEPS,
+           SYS_CLK_HZ / (DITHER_TOP + 1) / DITHER_STEPS / 1000);
+    printf("compare values out of range: %u\n", bad_range);
+    printf("dithered, one pattern:   mean error %.6f, max %.6f\n", sum_pass / 65536, max_pass);
+    printf("dithered, %u periods:  mean error %.6f, max %.6f\n", LONG_RUN, sum_long / 65536, max_long);
+    printf("dithered, any %u periods: max error %.3f\n", WINDOW, max_window);
+    printf("truncated:               mean error %.6f, max %.6f\n", sum_trunc / 65536, max_trunc);
+    return bad_range != 0 || max_pass > 1e-9;
+}
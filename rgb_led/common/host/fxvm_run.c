@@ -0,0 +1,181 @@
+/**
+ * @brief Host harness for the effect VM
+ *
+ * Runs the loader and interpreter checks, then each assembled script given
+ * on the command line for a number of frames on a 1000 pixel strip, and
+ * reports instructions per pixel, budget use, instructions per second and
+ * a checksum of the output.
+ *
+ *     python3 ../fxasm.py --format bin -o rainbow.fxb ../../strip/effects/rainbow.fx
+ *     cc -O2 -I.. -o fxvm_run fxvm_run.c ../fxvm.c ../rgb_color.c && ./fxvm_run rainbow.fxb
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Defines */
+#define NUM_PIXELS      1000
+#define FRAMES          300
+
+#define count_of(a)     (sizeof(a) / sizeof((a)[0]))
+
+#define INSN(op, d, a, b, imm) \
+    (((uint32_t) (op) << 24) | ((d) << 20) | ((a) << 16) | ((b) << 12) | ((imm) & 0xFFF))
+#define INSN16(op, d, imm) (((uint32_t) (op) << 24) | ((d) << 20) | ((imm) & 0xFFFF))
+
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "fxvm.h"
+
+/* Globals */
+static fxvm_t vm;
+static rgb_t pixels[NUM_PIXELS];
+static unsigned fails;
+
+/* Code */
+static double now_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void expect(const char *what, int got, int want) {
+    if (got != want) {
+        printf("FAIL %s: got %d, want %d\n", what, got, want);
+        fails++;
+    }
+}
+
+static void self_test(void) {
+    uint32_t bad_op[] = { FXVM_MAGIC, 2, INSN(200, 0, 0, 0, 0), INSN(FXVM_END, 0, 0, 0, 0) };
+    uint32_t bad_jump[] = { FXVM_MAGIC, 2, INSN(FXVM_JZ, 0, 3, 0, 2), INSN(FXVM_END, 0, 0, 0, 0) };
+    uint32_t bad_mem[] = { FXVM_MAGIC, 2, INSN(FXVM_LD, 3, 0, 0, FXVM_MEM_WORDS),
+                           INSN(FXVM_END, 0, 0, 0, 0) };
+    uint32_t no_end[] = { FXVM_MAGIC, 1, INSN(FXVM_MOV, 3, 0, 0, 0) };
+    uint32_t spin[] = { FXVM_MAGIC, 1, INSN(FXVM_JMP, 0, 0, 0, 0) };
+
+    expect("bad magic", fxvm_load(&vm, bad_op + 1, 3), FXVM_ERR_MAGIC);
+    expect("bad size", fxvm_load(&vm, bad_op, 3), FXVM_ERR_SIZE);
+    expect("bad op", fxvm_load(&vm, bad_op, 4), FXVM_ERR_OP);
+    expect("bad jump", fxvm_load(&vm, bad_jump, 4), FXVM_ERR_JUMP);
+    expect("bad mem", fxvm_load(&vm, bad_mem, 4), FXVM_ERR_MEM);
+    expect("no end", fxvm_load(&vm, no_end, 3), FXVM_ERR_JUMP);
+
+    expect("spin load", fxvm_load(&vm, spin, 3), FXVM_OK);
+    expect("spin budget", fxvm_frame(&vm, pixels, NUM_PIXELS, 0), FXVM_ERR_BUDGET);
+
+    // Arithmetic, clamping, sine, memory, loops and registers set per pixel
+    uint32_t ops[] = {
+        FXVM_MAGIC, 19,
+        INSN16(FXVM_LDI, 3, -5),            // r3 = -5
+        INSN(FXVM_ADDI, 3, 3, 0, 300),      // r3 = 295, red clamps to 255
+        INSN16(FXVM_LDI, 4, 0x1234),
+        INSN16(FXVM_LUI, 4, 0x0001),        // r4 = 0x11234
+        INSN(FXVM_SHR, 4, 4, 0, 10),        // r4 = 68
+        INSN16(FXVM_LDI, 5, 64),
+        INSN(FXVM_SIN, 5, 5, 0, 0),         // r5 = 255
+        INSN16(FXVM_LDI, 6, 128),
+        INSN(FXVM_MULQ, 5, 5, 6, 0),        // r5 = 127
+        INSN(FXVM_LD, 7, 0, 0, 5),          // mem[5] += index
+        INSN(FXVM_ADD, 7, 7, FXVM_R_INDEX, 0),
+        INSN(FXVM_ST, 7, 0, 0, 5),
+        INSN16(FXVM_LDI, 8, 3),             // loop 3 times: r4 -= 1
+        INSN(FXVM_ADDI, 4, 4, 0, -1),
+        INSN(FXVM_ADDI, 8, 8, 0, -1),
+        INSN(FXVM_JNZ, 0, 8, 0, 13),
+        INSN(FXVM_SUB, 4, 4, FXVM_R_FRAME, 0),  // g = 65 - frame
+        INSN(FXVM_RGB, 3, 4, 5, 0),
+        INSN(FXVM_END, 0, 0, 0, 0),
+    };
+    expect("ops load", fxvm_load(&vm, ops, count_of(ops)), FXVM_OK);
+    expect("ops frame", fxvm_frame(&vm, pixels, 10, 5), FXVM_OK);
+    expect("ops red", pixels[9].r, 255);
+    expect("ops green", pixels[9].g, 60);
+    expect("ops blue", pixels[9].b, 127);
+    expect("ops memory", vm.mem[5], 45);
+    expect("ops steps", vm.steps, 10 * 25);
+
+    // Arithmetic wraps at 32 bits, MULQ keeps the whole product
+    uint32_t wrap[] = {
+        FXVM_MAGIC, 13,
+        INSN16(FXVM_LDI, 3, -1),
+        INSN16(FXVM_LUI, 3, 0x7FFF),        // r3 = INT32_MAX
+        INSN(FXVM_ADD, 4, 3, 3, 0),
+        INSN(FXVM_ST, 4, 0, 0, 0),          // mem[0] = -2
+        INSN(FXVM_MUL, 4, 3, 3, 0),
+        INSN(FXVM_ST, 4, 0, 0, 1),          // mem[1] = 1
+        INSN16(FXVM_LDI, 5, 256),
+        INSN(FXVM_MULQ, 4, 3, 5, 0),
+        INSN(FXVM_ST, 4, 0, 0, 2),          // mem[2] = INT32_MAX
+        INSN(FXVM_ADDI, 4, 3, 0, 1),
+        INSN(FXVM_SUB, 4, 4, 5, 0),
+        INSN(FXVM_ST, 4, 0, 0, 3),          // mem[3] = INT32_MAX - 255
+        INSN(FXVM_END, 0, 0, 0, 0),
+    };
+    expect("wrap load", fxvm_load(&vm, wrap, count_of(wrap)), FXVM_OK);
+    expect("wrap frame", fxvm_frame(&vm, pixels, 1, 0), FXVM_OK);
+    expect("wrap add", vm.mem[0], -2);
+    expect("wrap mul", vm.mem[1], 1);
+    expect("wrap mulq", vm.mem[2], INT32_MAX);
+    expect("wrap addi sub", vm.mem[3], INT32_MAX - 255);
+}
+
+static int run_script(const char *path) {
+    static uint32_t image[FXVM_CODE_WORDS + 2];
+    FILE *f = fopen(path, "rb");
+
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    size_t words = fread(image, sizeof(uint32_t), count_of(image), f);
+    fclose(f);
+
+    int status = fxvm_load(&vm, image, words);
+    if (status != FXVM_OK) {
+        printf("%s: load failed %d\n", path, status);
+        return 1;
+    }
+
+    uint64_t steps = 0;
+    uint32_t max_steps = 0;
+    uint32_t sum = 0;
+    double start = now_s();
+    for (uint32_t frame = 0; frame < FRAMES; frame++) {
+        status = fxvm_frame(&vm, pixels, NUM_PIXELS, frame);
+        if (status != FXVM_OK) {
+            printf("%s: frame %u failed %d\n", path, frame, status);
+            return 1;
+        }
+        steps += vm.steps;
+        max_steps = vm.steps > max_steps ? vm.steps : max_steps;
+        for (int i = 0; i < NUM_PIXELS; i++) {
+            sum = sum * 31 + (pixels[i].r << 16 | pixels[i].g << 8 | pixels[i].b);
+        }
+    }
+    double secs = now_s() - start;
+
+    printf("%s: %.1f insns/pixel, worst frame %u%% of budget, %.1f M insns/s, "
+           "%.0f fps at %d pixels, checksum %08x\n",
+           path, (double) steps / FRAMES / NUM_PIXELS,
+           max_steps * 100 / (NUM_PIXELS * FXVM_PIXEL_STEPS), steps / secs / 1e6,
+           FRAMES / secs, NUM_PIXELS, sum);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int failed = 0;
+
+    self_test();
+    printf("self test: %u failures\n", fails);
+
+    for (int i = 1; i < argc; i++) {
+        failed |= run_script(argv[i]);
+    }
+    return fails || failed;
+}
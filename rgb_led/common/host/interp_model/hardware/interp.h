@@ -0,0 +1,91 @@
+/**
+ * @brief Host model of the RP2040 interpolator
+ *
+ * Just enough of the SDK's hardware/interp.h for led_kern.c: shift, mask,
+ * sign extension, cross input and lane 1 blend, following the RP2040
+ * datasheet. Bases hold host pointers, so they are uintptr_t here.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+typedef struct {
+    uint shift;
+    uint mask_lsb;
+    uint mask_msb;
+    bool is_signed;
+    bool cross_input;
+    bool blend;
+} interp_config;
+
+typedef struct {
+    uint32_t accum[2];
+    uintptr_t base[3];
+    interp_config ctrl[2];
+} interp_hw_t;
+
+typedef interp_hw_t interp_hw_save_t;
+
+extern interp_hw_t interp_model;
+#define interp0 (&interp_model)
+
+static inline interp_config interp_default_config(void) {
+    return (interp_config) { .mask_msb = 31 };
+}
+
+static inline void interp_config_set_shift(interp_config *c, uint shift) { c->shift = shift; }
+static inline void interp_config_set_signed(interp_config *c, bool s) { c->is_signed = s; }
+static inline void interp_config_set_cross_input(interp_config *c, bool cross) { c->cross_input = cross; }
+static inline void interp_config_set_blend(interp_config *c, bool blend) { c->blend = blend; }
+
+static inline void interp_config_set_mask(interp_config *c, uint lsb, uint msb) {
+    c->mask_lsb = lsb;
+    c->mask_msb = msb;
+}
+
+static inline void interp_set_config(interp_hw_t *interp, uint lane, interp_config *c) {
+    interp->ctrl[lane] = *c;
+}
+
+static inline void interp_set_base(interp_hw_t *interp, uint lane, uintptr_t val) { interp->base[lane] = val; }
+static inline void interp_set_accumulator(interp_hw_t *interp, uint lane, uint32_t val) { interp->accum[lane] = val; }
+
+// Halves are sign extended only for signed lanes
+static inline void interp_set_base_both(interp_hw_t *interp, uint32_t val) {
+    interp->base[0] = interp->ctrl[0].is_signed ? (uintptr_t) (int16_t) val : (val & 0xFFFF);
+    interp->base[1] = interp->ctrl[1].is_signed ? (uintptr_t) (int16_t) (val >> 16) : (val >> 16);
+}
+
+static inline void interp_save(interp_hw_t *interp, interp_hw_save_t *save) { *save = *interp; }
+static inline void interp_restore(interp_hw_t *interp, interp_hw_save_t *save) { *interp = *save; }
+
+// Shift and mask output of a lane, before its base is added
+static inline uint32_t interp_model_masked(interp_hw_t *interp, uint lane) {
+    const interp_config *c = &interp->ctrl[lane];
+    uint32_t in = interp->accum[c->cross_input ? 1 - lane : lane];
+    uint32_t mask = (uint32_t) ((2ull << c->mask_msb) - (1ull << c->mask_lsb));
+    uint32_t x = (in >> c->shift) & mask;
+
+    if (c->is_signed && (x & (1u << c->mask_msb))) {
+        x |= ~(uint32_t) ((2ull << c->mask_msb) - 1);
+    }
+    return x;
+}
+
+// Blend: base0 * (256 - alpha) / 256 + base1 * alpha / 256 as one floor
+static inline uintptr_t interp_peek_lane_result(interp_hw_t *interp, uint lane) {
+    uint32_t x = interp_model_masked(interp, lane);
+
+    if (lane == 1 && interp->ctrl[0].blend) {
+        uint64_t alpha = x & 0xFF;
+        return (uintptr_t) ((interp->base[0] * (256 - alpha) + interp->base[1] * alpha) >> 8);
+    }
+    return interp->base[lane] + x;
+}
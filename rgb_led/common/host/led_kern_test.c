@@ -0,0 +1,134 @@
+/**
+ * @brief Host test and benchmark for the effect kernels
+ *
+ * Builds led_kern.c twice over: the interpolator versions run against a
+ * software model of the interpolator and must match the C versions byte
+ * for byte, exhaustively for blend and scale and over random buffers,
+ * lengths and alignments for the lookups. The C versions are then timed.
+ *
+ *     cc -O2 -DPICO_ON_DEVICE=1 -I.. -Iinterp_model -o led_kern_test led_kern_test.c ../led_kern.c && ./led_kern_test
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Defines */
+#define BUF_LEN         3000    // 1000 RGB pixels
+#define BENCH_PASSES    20000
+
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "hardware/interp.h"
+#include "led_kern.h"
+
+/* Globals */
+interp_hw_t interp_model;
+
+static uint8_t in_a[BUF_LEN + 4];
+static uint8_t in_b[BUF_LEN + 4];
+static uint8_t out_c[BUF_LEN + 1];
+static uint8_t out_i[BUF_LEN + 1];
+static uint16_t out16_c[BUF_LEN + 1];
+static uint16_t out16_i[BUF_LEN + 1];
+static uint8_t lut8[256];
+static uint16_t lut16[256];
+
+/* Code */
+static double now_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static unsigned test_lookups(void) {
+    unsigned fails = 0;
+
+    for (unsigned trial = 0; trial < 2000; trial++) {
+        size_t off = rand() % 4;
+        size_t n = rand() % 64;
+
+        if (trial == 0) {
+            n = BUF_LEN;
+        }
+        memset(out_i, 0xAA, sizeof(out_i));
+        memset(out16_i, 0xAA, sizeof(out16_i));
+
+        kern_lut8_c(out_c, in_a + off, n, lut8);
+        kern_lut8_interp(out_i, in_a + off, n, lut8);
+        fails += memcmp(out_c, out_i, n) != 0 || out_i[n] != 0xAA;
+
+        kern_lut16_c(out16_c, in_a + off, n, lut16);
+        kern_lut16_interp(out16_i, in_a + off, n, lut16);
+        fails += memcmp(out16_c, out16_i, n * 2) != 0 || out16_i[n] != 0xAAAA;
+    }
+    return fails;
+}
+
+// Every a, b and alpha
+static unsigned test_blends(void) {
+    static uint8_t a[65536], b[65536], oc[65536], oi[65536];
+    unsigned fails = 0;
+
+    for (unsigned i = 0; i < 65536; i++) {
+        a[i] = i;
+        b[i] = i >> 8;
+    }
+    for (unsigned alpha = 0; alpha < 256; alpha++) {
+        kern_lerp8_c(oc, a, b, 65536, alpha);
+        kern_lerp8_interp(oi, a, b, 65536, alpha);
+        fails += memcmp(oc, oi, 65536) != 0;
+
+        kern_scale8_c(oc, a, 256, alpha);
+        kern_scale8_interp(oi, a, 256, alpha);
+        fails += memcmp(oc, oi, 256) != 0;
+    }
+    return fails;
+}
+
+static double bench_ns(int kernel) {
+    volatile uint32_t sink = 0;
+    double start = now_s();
+
+    for (unsigned p = 0; p < BENCH_PASSES; p++) {
+        in_a[p % BUF_LEN] = p;
+        switch (kernel) {
+            case 0: kern_lut8_c(out_c, in_a, BUF_LEN, lut8); break;
+            case 1: kern_lut16_c(out16_c, in_a, BUF_LEN, lut16); break;
+            case 2: kern_lerp8_c(out_c, in_a, in_b, BUF_LEN, p); break;
+            default: kern_scale8_c(out_c, in_a, BUF_LEN, p); break;
+        }
+        sink += out_c[p % BUF_LEN] + out16_c[p % BUF_LEN];
+    }
+    // Per pixel, three channel bytes
+    return (now_s() - start) * 1e9 / BENCH_PASSES / (BUF_LEN / 3);
+}
+
+int main(void) {
+    const char *names[] = { "lut8", "lut16", "lerp8", "scale8" };
+
+    srand(1);
+    for (unsigned i = 0; i < sizeof(in_a); i++) {
+        in_a[i] = rand();
+        in_b[i] = rand();
+    }
+    for (unsigned i = 0; i < 256; i++) {
+        lut8[i] = (i * i) >> 8;
+        lut16[i] = rand();
+    }
+
+    unsigned lookup_fails = test_lookups();
+    unsigned blend_fails = test_blends();
+    printf("interp model vs C: lookups %u mismatches, blend/scale %u mismatches\n",
+           lookup_fails, blend_fails);
+
+    for (int k = 0; k < 4; k++) {
+        printf("%-6s C on host: %.2f ns/pixel\n", names[k], bench_ns(k));
+    }
+    return lookup_fails || blend_fails;
+}
@@ -0,0 +1,88 @@
+/**
+ * @brief Host check and benchmark for the integer color engine
+ *
+ * Compares rgb_color.c against the float reference over the whole hue
+ * circle and a grid of saturations and values, then times both.
+ *
+ *     cc -O2 -I.. -o rgb_color_bench rgb_color_bench.c ../rgb_color.c && ./rgb_color_bench
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "rgb_color.h"
+#include "rgb_color_ref.h"
+
+/* Code */
+static double now_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int diff(int a, int b) {
+    return abs(a - b);
+}
+
+int main(void) {
+    static const float scale[3] = { 1.0f, 0.72f, 0.55f };
+    rgb_calib_t cal;
+    int max_err = 0, max_lut_err = 0;
+    uint64_t sum_err = 0, n = 0;
+
+    rgb_calib_init(&cal, scale[0] * RGB_CALIB_ONE, scale[1] * RGB_CALIB_ONE,
+                   scale[2] * RGB_CALIB_ONE);
+
+    for (uint32_t h = 0; h < 65536; h += 7) {
+        for (uint32_t s = 0; s < 256; s += 15) {
+            for (uint32_t v = 0; v < 256; v += 15) {
+                hsv_t hsv = { h, s, v };
+                rgb_t a = rgb_from_hsv(hsv), b = rgb_from_hsv_ref(hsv);
+                int e = diff(a.r, b.r) + diff(a.g, b.g) + diff(a.b, b.b);
+
+                max_err = e > max_err ? e : max_err;
+                sum_err += e;
+                n += 3;
+            }
+        }
+    }
+    for (int ch = 0; ch < 3; ch++) {
+        for (int i = 0; i < 256; i++) {
+            int e = diff(cal.lut[ch][i], rgb_gamma_ref(i, scale[ch]));
+
+            max_lut_err = e > max_lut_err ? e : max_lut_err;
+        }
+    }
+    printf("hsv->rgb: max error %d LSB (sum of channels), mean %.3f LSB per channel\n",
+           max_err, (double) sum_err / n);
+    printf("gamma+calibration: max error %d / 65535\n", max_lut_err);
+
+    // Whole pipeline, HSV in and PWM levels out
+    const uint32_t iters = 20 * 1000 * 1000;
+    volatile uint32_t sink = 0;
+    double t0 = now_s();
+    for (uint32_t i = 0; i < iters; i++) {
+        hsv_t hsv = { i * 2654435761u >> 16, i >> 3, i };
+        rgb16_t out = rgb_calib_apply(&cal, rgb_from_hsv(hsv));
+        sink += out.r ^ out.g ^ out.b;
+    }
+    double t1 = now_s();
+    for (uint32_t i = 0; i < iters; i++) {
+        hsv_t hsv = { i * 2654435761u >> 16, i >> 3, i };
+        rgb_t c = rgb_from_hsv_ref(hsv);
+        sink += rgb_gamma_ref(c.r, scale[0]) ^ rgb_gamma_ref(c.g, scale[1])
+              ^ rgb_gamma_ref(c.b, scale[2]);
+    }
+    double t2 = now_s();
+
+    printf("integer: %.1f M conversions/s, float: %.1f M conversions/s\n",
+           iters / (t1 - t0) / 1e6, iters / (t2 - t1) / 1e6);
+    return max_err > 6 || max_lut_err > 2;
+}
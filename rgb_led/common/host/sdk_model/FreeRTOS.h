@@ -0,0 +1,29 @@
+/**
+ * @brief Host stand-in for the FreeRTOS types the drivers under test use
+ *
+ * Notifications given from an interrupt are only counted.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef long BaseType_t;
+typedef void *TaskHandle_t;
+
+#define pdFALSE                 0
+#define pdTRUE                  1
+#define portYIELD_FROM_ISR(x)   ((void) (x))
+
+extern uint32_t task_model_notifies;
+
+static inline void vTaskNotifyGiveIndexedFromISR(TaskHandle_t task, unsigned index,
+                                                 BaseType_t *woken) {
+    (void) task;
+    (void) index;
+    task_model_notifies++;
+    *woken = pdTRUE;
+}
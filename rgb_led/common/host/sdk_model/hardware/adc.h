@@ -0,0 +1,66 @@
+/**
+ * @brief Host model of the RP2040 ADC and its FIFO
+ *
+ * adc_model_convert(), in dma.h, stands in for the conversions: while it runs
+ * each one pushes the next value of a 16-bit counter into the 4 entry
+ * FIFO, or sets OVER when it is full, and then lets the DMA model run.
+ * Reading adc_hw->fifo through the DMA pops it.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include "pico/stdlib.h"
+
+#define ADC_FCS_OVER_BITS   (1u << 11)
+#define ADC_FCS_UNDER_BITS  (1u << 10)
+#define ADC_MODEL_FIFO_LEN  4
+
+typedef struct {
+    volatile uint32_t fifo;
+    volatile uint32_t fcs;
+} adc_hw_t;
+
+typedef struct {
+    adc_hw_t hw;
+    uint16_t fifo[ADC_MODEL_FIFO_LEN];
+    uint fifo_len;
+    uint16_t next;          // Value of the next conversion
+    uint input;
+    bool running;
+    float clkdiv;
+} adc_model_t;
+
+extern adc_model_t adc_model;
+#define adc_hw (&adc_model.hw)
+
+static inline void adc_init(void) {}
+static inline void adc_gpio_init(uint gpio) { (void) gpio; }
+static inline void adc_select_input(uint input) { adc_model.input = input; }
+static inline void adc_set_clkdiv(float clkdiv) { adc_model.clkdiv = clkdiv; }
+static inline void adc_run(bool run) { adc_model.running = run; }
+
+static inline void adc_fifo_setup(bool en, bool dreq_en, uint16_t dreq_thresh, bool err_in_fifo,
+                                  bool byte_shift) {
+    hard_assert(en && dreq_en && dreq_thresh == 1 && !err_in_fifo && !byte_shift);
+}
+
+static inline void adc_fifo_drain(void) {
+    adc_model.fifo_len = 0;
+}
+
+// A DMA read of the FIFO register
+static inline uint16_t adc_model_pop(void) {
+    if (adc_model.fifo_len == 0) {
+        adc_model.hw.fcs |= ADC_FCS_UNDER_BITS;
+        return 0;
+    }
+    uint16_t val = adc_model.fifo[0];
+    for (uint i = 1; i < adc_model.fifo_len; i++) {
+        adc_model.fifo[i - 1] = adc_model.fifo[i];
+    }
+    adc_model.fifo_len--;
+    return val;
+}
@@ -0,0 +1,254 @@
+/**
+ * @brief Host model of the RP2040 DMA, for the ADC drivers
+ *
+ * Just enough of the SDK's hardware/dma.h for adc_capture.c: channels with
+ * a DREQ, read and write increment, a write ring, chaining, IRQ 1 flags,
+ * and the TRANS_COUNT trigger alias as a control channel target. Writing
+ * TRANS_COUNT sets the count a trigger reloads, as on the chip. Addresses
+ * are host pointers, so registers are uintptr_t here.
+ *
+ * An abort of a busy channel fires its chain, as the datasheet warns it
+ * can, so a driver that stops chained channels has to break the chain
+ * first. Channels only move data inside dma_model_run(), which runs
+ * everything that is ready in round robin until nothing is.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+
+#define NUM_DMA_CHANNELS    12
+#define DREQ_ADC            36
+#define DREQ_FORCE          0x3F
+
+enum dma_channel_transfer_size { DMA_SIZE_8 = 0, DMA_SIZE_16 = 1, DMA_SIZE_32 = 2 };
+
+typedef struct {
+    uint size;              // Bytes
+    bool read_increment;
+    bool write_increment;
+    uint ring_bits;         // 0 for no ring
+    bool ring_write;
+    uint dreq;
+    uint chain_to;
+} dma_channel_config;
+
+typedef struct {
+    volatile uintptr_t read_addr;
+    volatile uintptr_t write_addr;
+    volatile uintptr_t transfer_count;      // Remaining
+    volatile uintptr_t al1_transfer_count_trig;
+} dma_channel_hw_t;
+
+typedef struct {
+    dma_channel_hw_t ch[NUM_DMA_CHANNELS];
+} dma_hw_t;
+
+typedef struct {
+    dma_hw_t hw;
+    dma_channel_config config[NUM_DMA_CHANNELS];
+    uint32_t reload[NUM_DMA_CHANNELS];      // Last count written
+    bool claimed[NUM_DMA_CHANNELS];
+    bool busy[NUM_DMA_CHANNELS];
+    bool irq1_enabled[NUM_DMA_CHANNELS];
+    bool irq1[NUM_DMA_CHANNELS];
+    uint32_t chain_triggers;
+} dma_model_t;
+
+extern dma_model_t dma_model;
+#define dma_hw (&dma_model.hw)
+
+static inline dma_channel_hw_t *dma_channel_hw_addr(uint chan) {
+    return &dma_hw->ch[chan];
+}
+
+static inline uint dma_claim_unused_channel(bool required) {
+    for (uint c = 0; c < NUM_DMA_CHANNELS; c++) {
+        if (!dma_model.claimed[c]) {
+            dma_model.claimed[c] = true;
+            return c;
+        }
+    }
+    hard_assert(!required);
+    return -1;
+}
+
+static inline dma_channel_config dma_channel_get_default_config(uint chan) {
+    return (dma_channel_config) {
+        .size = 4, .read_increment = true, .dreq = DREQ_FORCE, .chain_to = chan,
+    };
+}
+
+static inline void channel_config_set_transfer_data_size(dma_channel_config *c,
+                                                         enum dma_channel_transfer_size size) {
+    c->size = 1u << size;
+}
+
+static inline void channel_config_set_read_increment(dma_channel_config *c, bool incr) { c->read_increment = incr; }
+static inline void channel_config_set_write_increment(dma_channel_config *c, bool incr) { c->write_increment = incr; }
+static inline void channel_config_set_dreq(dma_channel_config *c, uint dreq) { c->dreq = dreq; }
+static inline void channel_config_set_chain_to(dma_channel_config *c, uint chan) { c->chain_to = chan; }
+
+static inline void channel_config_set_ring(dma_channel_config *c, bool write, uint size_bits) {
+    c->ring_write = write;
+    c->ring_bits = size_bits;
+}
+
+static inline void dma_channel_trigger_model(uint chan) {
+    dma_model.busy[chan] = true;
+    dma_hw->ch[chan].transfer_count = dma_model.reload[chan];
+}
+
+static inline void dma_channel_set_config(uint chan, const dma_channel_config *c, bool trigger) {
+    dma_model.config[chan] = *c;
+    if (trigger) {
+        dma_channel_trigger_model(chan);
+    }
+}
+
+static inline void dma_channel_set_read_addr(uint chan, const volatile void *addr, bool trigger) {
+    dma_hw->ch[chan].read_addr = (uintptr_t) addr;
+    if (trigger) {
+        dma_channel_trigger_model(chan);
+    }
+}
+
+static inline void dma_channel_set_write_addr(uint chan, volatile void *addr, bool trigger) {
+    dma_hw->ch[chan].write_addr = (uintptr_t) addr;
+    if (trigger) {
+        dma_channel_trigger_model(chan);
+    }
+}
+
+static inline void dma_channel_set_trans_count(uint chan, uint32_t count, bool trigger) {
+    dma_model.reload[chan] = count;
+    if (trigger) {
+        dma_channel_trigger_model(chan);
+    }
+}
+
+static inline void dma_channel_configure(uint chan, const dma_channel_config *c,
+                                         volatile void *write_addr, const volatile void *read_addr,
+                                         uint transfer_count, bool trigger) {
+    dma_channel_set_read_addr(chan, read_addr, false);
+    dma_channel_set_write_addr(chan, write_addr, false);
+    dma_channel_set_trans_count(chan, transfer_count, false);
+    dma_channel_set_config(chan, c, trigger);
+}
+
+static inline void dma_channel_start(uint chan) {
+    dma_channel_trigger_model(chan);
+}
+
+static inline void dma_channel_abort(uint chan) {
+    uint chain = dma_model.config[chan].chain_to;
+
+    if (dma_model.busy[chan] && chain != chan) {
+        dma_model.chain_triggers++;
+        dma_channel_trigger_model(chain);
+    }
+    dma_model.busy[chan] = false;
+}
+
+static inline void dma_channel_set_irq1_enabled(uint chan, bool enabled) { dma_model.irq1_enabled[chan] = enabled; }
+static inline bool dma_channel_get_irq1_status(uint chan) { return dma_model.irq1[chan]; }
+static inline void dma_channel_acknowledge_irq1(uint chan) { dma_model.irq1[chan] = false; }
+
+// A write into another channel's registers, the control channel's job
+static inline void dma_model_write_reg(uintptr_t addr, uint32_t val) {
+    uintptr_t offset = addr - (uintptr_t) dma_hw->ch;
+    uint chan = offset / sizeof(dma_channel_hw_t);
+
+    hard_assert(addr == (uintptr_t) &dma_hw->ch[chan].al1_transfer_count_trig);
+    dma_model.reload[chan] = val;
+    dma_channel_trigger_model(chan);
+}
+
+static inline bool dma_model_ready(uint chan) {
+    if (!dma_model.busy[chan]) {
+        return false;
+    }
+    return dma_model.config[chan].dreq == DREQ_FORCE
+           || (dma_model.config[chan].dreq == DREQ_ADC && adc_model.fifo_len > 0);
+}
+
+// One transfer on chan, then the count, IRQ and chain on the last one
+static inline void dma_model_transfer(uint chan) {
+    dma_channel_hw_t *hw = &dma_hw->ch[chan];
+    const dma_channel_config *c = &dma_model.config[chan];
+    uint32_t val = 0;
+
+    if (hw->read_addr == (uintptr_t) &adc_hw->fifo) {
+        val = adc_model_pop();
+    } else {
+        memcpy(&val, (const void *) hw->read_addr, c->size);
+    }
+
+    if (hw->write_addr >= (uintptr_t) dma_hw->ch
+        && hw->write_addr < (uintptr_t) (dma_hw->ch + NUM_DMA_CHANNELS)) {
+        dma_model_write_reg(hw->write_addr, val);
+    } else {
+        memcpy((void *) hw->write_addr, &val, c->size);
+    }
+
+    if (c->read_increment) {
+        hw->read_addr += c->size;
+    }
+    if (c->write_increment) {
+        uintptr_t mask = c->ring_write && c->ring_bits ? (1u << c->ring_bits) - 1 : ~(uintptr_t) 0;
+        hw->write_addr = (hw->write_addr & ~mask) | ((hw->write_addr + c->size) & mask);
+    }
+
+    if (--hw->transfer_count == 0) {
+        dma_model.busy[chan] = false;
+        if (dma_model.irq1_enabled[chan]) {
+            dma_model.irq1[chan] = true;
+        }
+        if (c->chain_to != chan) {
+            dma_channel_trigger_model(c->chain_to);
+        }
+    }
+}
+
+static inline void dma_model_run(void) {
+    for (bool moved = true; moved; ) {
+        moved = false;
+        for (uint chan = 0; chan < NUM_DMA_CHANNELS; chan++) {
+            if (dma_model_ready(chan)) {
+                dma_model_transfer(chan);
+                moved = true;
+            }
+        }
+    }
+}
+
+static inline bool dma_model_any_busy(void) {
+    for (uint chan = 0; chan < NUM_DMA_CHANNELS; chan++) {
+        if (dma_model.busy[chan]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// n conversions, the DMA keeps up with each one
+static inline void adc_model_convert(uint n) {
+    while (n--) {
+        if (!adc_model.running) {
+            return;
+        }
+        if (adc_model.fifo_len < ADC_MODEL_FIFO_LEN) {
+            adc_model.fifo[adc_model.fifo_len++] = adc_model.next;
+        } else {
+            adc_model.hw.fcs |= ADC_FCS_OVER_BITS;
+        }
+        adc_model.next++;
+        dma_model_run();
+    }
+}
@@ -0,0 +1,62 @@
+/**
+ * @brief Host model of the GPIO inputs and edge interrupts
+ *
+ * gpio_model_set() drives a pin's level. An edge on a pin with that edge
+ * enabled calls the registered callback straight away, as the interrupt
+ * would, with the events the pin saw.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include "pico/stdlib.h"
+
+#define NUM_BANK0_GPIOS     30
+#define IO_IRQ_BANK0        13
+#define GPIO_IN             false
+
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+
+typedef struct {
+    bool level[NUM_BANK0_GPIOS];
+    uint32_t irq_events[NUM_BANK0_GPIOS];
+    gpio_irq_callback_t callback;
+} gpio_model_t;
+
+extern gpio_model_t gpio_model;
+
+static inline void gpio_init(uint gpio) { (void) gpio; }
+static inline void gpio_set_dir(uint gpio, bool out) { (void) gpio; (void) out; }
+static inline void gpio_pull_up(uint gpio) { (void) gpio; }
+static inline bool gpio_get(uint gpio) { return gpio_model.level[gpio]; }
+
+static inline void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled,
+                                                      gpio_irq_callback_t callback) {
+    gpio_model.irq_events[gpio] = enabled ? events : 0;
+    gpio_model.callback = callback;
+}
+
+// One edge, or both at once for a glitch faster than the interrupt, with
+// the level the pin is left at
+static inline void gpio_model_edges(uint gpio, uint32_t events, bool level) {
+    gpio_model.level[gpio] = level;
+    events &= gpio_model.irq_events[gpio];
+    if (events && gpio_model.callback) {
+        gpio_model.callback(gpio, events);
+    }
+}
+
+static inline void gpio_model_set(uint gpio, bool level) {
+    if (level != gpio_model.level[gpio]) {
+        gpio_model_edges(gpio, level ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL, level);
+    }
+}
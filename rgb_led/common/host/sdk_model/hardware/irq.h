@@ -0,0 +1,39 @@
+/**
+ * @brief Host model of the SDK's shared interrupt handlers
+ *
+ * Handlers are only recorded, the test calls them when it wants the
+ * interrupt taken, which is how it models interrupt latency.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include "pico/stdlib.h"
+
+#define DMA_IRQ_0       11
+#define DMA_IRQ_1       12
+#define IRQ_MODEL_NUM   32
+
+#define PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY 0x80
+
+typedef void (*irq_handler_t)(void);
+
+extern irq_handler_t irq_model_handlers[IRQ_MODEL_NUM];
+
+static inline void irq_add_shared_handler(uint num, irq_handler_t handler, uint8_t order) {
+    (void) order;
+    hard_assert(num < IRQ_MODEL_NUM && !irq_model_handlers[num]);
+    irq_model_handlers[num] = handler;
+}
+
+static inline void irq_set_enabled(uint num, bool enabled) {
+    (void) num;
+    (void) enabled;
+}
+
+static inline void irq_set_priority(uint num, uint8_t priority) {
+    (void) num;
+    (void) priority;
+}
@@ -0,0 +1,26 @@
+/**
+ * @brief Host stand-in for the SDK's pico/stdlib.h
+ *
+ * The microsecond timer is a variable the test sets.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+#define hard_assert(x)  assert(x)
+
+extern uint64_t time_model_us;
+
+static inline uint64_t time_us_64(void) { return time_model_us; }
+static inline uint32_t time_us_32(void) { return (uint32_t) time_model_us; }
+static inline void busy_wait_us(uint64_t us) { time_model_us += us; }
+static inline void tight_loop_contents(void) {}
@@ -0,0 +1,150 @@
+/**
+ * @brief Host stress test for the seqlock parameter block
+ *
+ * One writer thread publishes blocks whose words are all derived from a
+ * counter while reader threads copy them out as fast as they can and
+ * check every copy is whole. The same traffic through a plain shared
+ * struct is run first to show the check catches torn reads.
+ *
+ *     cc -O2 -pthread -I.. -o seqlock_stress seqlock_stress.c ../seqlock.c && ./seqlock_stress
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Defines */
+#define READERS         3
+#define RUN_SECONDS     2
+#define BLOCK_WORDS     16
+
+/* Includes */
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "seqlock.h"
+
+/* Globals */
+typedef struct {
+    uint32_t words[BLOCK_WORDS];
+} block_t;
+
+static block_t copies[2];
+static seqlock_t lock;
+static block_t plain;
+static volatile bool use_lock;
+static volatile bool stop;
+static unsigned long writes;
+
+static struct {
+    unsigned long reads;
+    unsigned long torn;
+    unsigned long stale;
+} stats[READERS];
+
+/* Code */
+static void fill(block_t *b, uint32_t n) {
+    for (int i = 0; i < BLOCK_WORDS; i++) {
+        b->words[i] = n * 2654435761u + i;
+    }
+}
+
+static bool whole(const block_t *b) {
+    uint32_t n = (b->words[0]) * 244002641u;     // Inverse of 2654435761 mod 2^32
+
+    for (int i = 0; i < BLOCK_WORDS; i++) {
+        if (b->words[i] != n * 2654435761u + i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void *writer(void *unused) {
+    block_t b;
+
+    for (uint32_t n = 1; !stop; n++, writes++) {
+        fill(&b, n);
+        if (use_lock) {
+            seqlock_write(&lock, &b);
+        } else {
+            for (int i = 0; i < BLOCK_WORDS; i++) {
+                __atomic_store_n(&plain.words[i], b.words[i], __ATOMIC_RELAXED);
+            }
+        }
+    }
+    return unused;
+}
+
+static void *reader(void *arg) {
+    int id = (int) (long) arg;
+    uint32_t last = 0;
+    block_t b;
+
+    while (!stop) {
+        if (use_lock) {
+            seqlock_read(&lock, &b);
+        } else {
+            for (int i = 0; i < BLOCK_WORDS; i++) {
+                b.words[i] = __atomic_load_n(&plain.words[i], __ATOMIC_RELAXED);
+            }
+        }
+        stats[id].reads++;
+        if (!whole(&b)) {
+            stats[id].torn++;
+        } else {
+            // Values never go backwards for one reader
+            uint32_t n = b.words[0] * 244002641u;
+            stats[id].stale += n < last;
+            last = n;
+        }
+    }
+    return NULL;
+}
+
+static unsigned long run(bool locked) {
+    pthread_t w, r[READERS];
+    unsigned long reads = 0, torn = 0, stale = 0;
+    block_t initial;
+
+    fill(&initial, 0);
+    seqlock_init(&lock, copies, sizeof(block_t), &initial);
+    plain = initial;
+    memset(stats, 0, sizeof(stats));
+    use_lock = locked;
+    stop = false;
+    writes = 0;
+
+    for (long i = 0; i < READERS; i++) {
+        pthread_create(&r[i], NULL, reader, (void *) i);
+    }
+    pthread_create(&w, NULL, writer, NULL);
+
+    struct timespec t = { RUN_SECONDS, 0 };
+    nanosleep(&t, NULL);
+    stop = true;
+
+    pthread_join(w, NULL);
+    for (int i = 0; i < READERS; i++) {
+        pthread_join(r[i], NULL);
+        reads += stats[i].reads;
+        torn += stats[i].torn;
+        stale += stats[i].stale;
+    }
+    printf("%-8s %lu writes, %lu reads, %lu torn, %lu out of order\n",
+           locked ? "seqlock" : "plain", writes, reads, torn, stale);
+    return torn + stale;
+}
+
+int main(void) {
+    unsigned long plain_bad = run(false);
+    unsigned long locked_bad = run(true);
+
+    if (plain_bad == 0) {
+        printf("plain struct never tore, the test did not exercise any races\n");
+    }
+    return locked_bad != 0;
+}
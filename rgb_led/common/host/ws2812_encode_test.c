@@ -0,0 +1,116 @@
+/**
+ * @brief Host test and benchmark for the WS2812 pixel encoders
+ *
+ * Decodes every encoded word the way the PIO program sends it, MSB first
+ * in 24 or 32 bit groups, and checks the bytes against a plain reference
+ * over random pixels and edge-case scales. Then times the encoders on a
+ * 1000 pixel frame.
+ *
+ *     cc -O2 -I.. -o ws2812_encode_test ws2812_encode_test.c ../ws2812_encode.c && ./ws2812_encode_test
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Defines */
+#define NUM_PIXELS      1000
+#define BENCH_FRAMES    20000
+
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ws2812_encode.h"
+
+/* Globals */
+static rgb_t pixels[NUM_PIXELS];
+static uint32_t words[NUM_PIXELS];
+
+/* Code */
+static double now_s(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Bits in wire order, as the state machine shifts them out of the OSR
+static void shift_out(uint32_t word, unsigned bits, uint8_t *bytes) {
+    for (unsigned i = 0; i < bits; i++) {
+        unsigned bit = (word >> (31 - i)) & 1;
+        bytes[i / 8] = (bytes[i / 8] << 1) | bit;
+    }
+}
+
+static unsigned scaled(unsigned c, unsigned scale) {
+    return scale >= WS2812_SCALE_FULL ? c : c * scale / 256;
+}
+
+static unsigned check(unsigned scale) {
+    unsigned fails = 0;
+    uint8_t b[4] = { 0 };
+
+    ws2812_encode_grb(words, pixels, NUM_PIXELS, scale);
+    for (unsigned i = 0; i < NUM_PIXELS; i++) {
+        shift_out(words[i], 24, b);
+        fails += b[0] != scaled(pixels[i].g, scale) || b[1] != scaled(pixels[i].r, scale)
+               || b[2] != scaled(pixels[i].b, scale) || (words[i] & 0xFF) != 0;
+    }
+
+    ws2812_encode_grbw(words, pixels, NUM_PIXELS, scale);
+    for (unsigned i = 0; i < NUM_PIXELS; i++) {
+        unsigned w = pixels[i].r;
+        w = pixels[i].g < w ? pixels[i].g : w;
+        w = pixels[i].b < w ? pixels[i].b : w;
+
+        shift_out(words[i], 32, b);
+        fails += b[0] != scaled(pixels[i].g - w, scale) || b[1] != scaled(pixels[i].r - w, scale)
+               || b[2] != scaled(pixels[i].b - w, scale) || b[3] != scaled(w, scale);
+    }
+    return fails;
+}
+
+static double bench(void (*encode)(uint32_t *, const rgb_t *, size_t, uint16_t), uint16_t scale) {
+    volatile uint32_t sink = 0;
+    double start = now_s();
+
+    for (unsigned f = 0; f < BENCH_FRAMES; f++) {
+        pixels[f % NUM_PIXELS].r = f;
+        encode(words, pixels, NUM_PIXELS, scale);
+        sink += words[f % NUM_PIXELS];
+    }
+    return (now_s() - start) / BENCH_FRAMES;
+}
+
+int main(void) {
+    const unsigned scales[] = { 0, 1, 127, 128, 255, 256, 1000 };
+    unsigned fails = 0;
+
+    srand(1);
+    for (unsigned i = 0; i < NUM_PIXELS; i++) {
+        pixels[i] = (rgb_t) { rand(), rand(), rand() };
+    }
+    // Corners, all equal goes all to white
+    pixels[0] = (rgb_t) { 255, 255, 255 };
+    pixels[1] = (rgb_t) { 0, 0, 0 };
+    pixels[2] = (rgb_t) { 255, 0, 128 };
+    pixels[3] = (rgb_t) { 77, 77, 77 };
+
+    for (unsigned s = 0; s < sizeof(scales) / sizeof(scales[0]); s++) {
+        unsigned f = check(scales[s]);
+        printf("scale %4u: %u mismatches\n", scales[s], f);
+        fails += f;
+    }
+
+    double grb_full = bench(ws2812_encode_grb, WS2812_SCALE_FULL);
+    double grb_scaled = bench(ws2812_encode_grb, 128);
+    double grbw = bench(ws2812_encode_grbw, 128);
+
+    printf("%u pixel frame: grb %.2f us, grb scaled %.2f us, grbw scaled %.2f us\n",
+           NUM_PIXELS, grb_full * 1e6, grb_scaled * 1e6, grbw * 1e6);
+    printf("wire time %.2f ms (grb), %.2f ms (grbw)\n",
+           NUM_PIXELS * 24 * 1.25e-3, NUM_PIXELS * 32 * 1.25e-3);
+    return fails != 0;
+}
@@ -0,0 +1,160 @@
+/**
+ * @brief Per-pixel kernels for the effect path
+ *
+ * Table lookups, blends and scaling over channel byte buffers. On the
+ * RP2040 they run on the core's interpolator: for lookups its two lanes
+ * pull two bytes out of a loaded word and add the table base, giving two
+ * addresses per accumulator write; for blends and scaling lane 1 in blend
+ * mode computes base0 + alpha * (base1 - base0) / 256 in one read. The C
+ * versions produce bit-identical results on any host.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#if PICO_ON_DEVICE
+#include "hardware/interp.h"
+#endif
+
+#include "led_kern.h"
+
+/* Code */
+void kern_lut8_c(uint8_t *out, const uint8_t *in, size_t n, const uint8_t *lut) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = lut[in[i]];
+    }
+}
+
+void kern_lut16_c(uint16_t *out, const uint8_t *in, size_t n, const uint16_t *lut) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = lut[in[i]];
+    }
+}
+
+// Rounds toward minus infinity like the interpolator, so a fade down
+// reaches b one step earlier than a fade up
+void kern_lerp8_c(uint8_t *out, const uint8_t *a, const uint8_t *b, size_t n, uint8_t alpha) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = a[i] + (((int32_t) b[i] - a[i]) * alpha >> 8);
+    }
+}
+
+void kern_scale8_c(uint8_t *out, const uint8_t *in, size_t n, uint8_t scale) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (in[i] * scale) >> 8;
+    }
+}
+
+#if PICO_ON_DEVICE
+// Lane 0 takes bits [shift, shift + 7] of accum 0 as an index, lane 1 the
+// next byte up through cross input, both scaled by the entry size
+static void kern_lut_setup(uintptr_t lut, uint size_bits) {
+    interp_config c = interp_default_config();
+
+    interp_config_set_mask(&c, size_bits, size_bits + 7);
+    interp_set_config(interp0, 0, &c);
+    interp_config_set_shift(&c, 8);
+    interp_config_set_cross_input(&c, true);
+    interp_set_config(interp0, 1, &c);
+
+    interp_set_base(interp0, 0, lut);
+    interp_set_base(interp0, 1, lut);
+}
+
+// Leading bytes until the input is word aligned
+static size_t kern_head(const uint8_t *in, size_t n) {
+    size_t head = (4 - ((uintptr_t) in & 3)) & 3;
+
+    return head < n ? head : n;
+}
+
+void kern_lut8_interp(uint8_t *out, const uint8_t *in, size_t n, const uint8_t *lut) {
+    interp_hw_save_t save;
+    size_t head = kern_head(in, n);
+    size_t i;
+
+    kern_lut8_c(out, in, head, lut);
+
+    interp_save(interp0, &save);
+    kern_lut_setup((uintptr_t) lut, 0);
+    for (i = head; i + 4 <= n; i += 4) {
+        uint32_t w = *(const uint32_t *) (in + i);
+
+        interp_set_accumulator(interp0, 0, w);
+        out[i] = *(const uint8_t *) (uintptr_t) interp_peek_lane_result(interp0, 0);
+        out[i + 1] = *(const uint8_t *) (uintptr_t) interp_peek_lane_result(interp0, 1);
+        interp_set_accumulator(interp0, 0, w >> 16);
+        out[i + 2] = *(const uint8_t *) (uintptr_t) interp_peek_lane_result(interp0, 0);
+        out[i + 3] = *(const uint8_t *) (uintptr_t) interp_peek_lane_result(interp0, 1);
+    }
+    interp_restore(interp0, &save);
+
+    kern_lut8_c(out + i, in + i, n - i, lut);
+}
+
+// Indexes are pre-shifted by one so the masks land them on entry offsets
+void kern_lut16_interp(uint16_t *out, const uint8_t *in, size_t n, const uint16_t *lut) {
+    interp_hw_save_t save;
+    size_t head = kern_head(in, n);
+    size_t i;
+
+    kern_lut16_c(out, in, head, lut);
+
+    interp_save(interp0, &save);
+    kern_lut_setup((uintptr_t) lut, 1);
+    for (i = head; i + 4 <= n; i += 4) {
+        uint32_t w = *(const uint32_t *) (in + i);
+
+        interp_set_accumulator(interp0, 0, w << 1);
+        out[i] = *(const uint16_t *) (uintptr_t) interp_peek_lane_result(interp0, 0);
+        out[i + 1] = *(const uint16_t *) (uintptr_t) interp_peek_lane_result(interp0, 1);
+        interp_set_accumulator(interp0, 0, w >> 15);
+        out[i + 2] = *(const uint16_t *) (uintptr_t) interp_peek_lane_result(interp0, 0);
+        out[i + 3] = *(const uint16_t *) (uintptr_t) interp_peek_lane_result(interp0, 1);
+    }
+    interp_restore(interp0, &save);
+
+    kern_lut16_c(out + i, in + i, n - i, lut);
+}
+
+// Blend mode on lane 0, lane 1's masked accumulator is the alpha
+static void kern_blend_setup(uint8_t alpha) {
+    interp_config c = interp_default_config();
+
+    interp_config_set_blend(&c, true);
+    interp_set_config(interp0, 0, &c);
+    c = interp_default_config();
+    interp_config_set_mask(&c, 0, 7);
+    interp_set_config(interp0, 1, &c);
+    interp_set_accumulator(interp0, 1, alpha);
+}
+
+void kern_lerp8_interp(uint8_t *out, const uint8_t *a, const uint8_t *b, size_t n, uint8_t alpha) {
+    interp_hw_save_t save;
+
+    interp_save(interp0, &save);
+    kern_blend_setup(alpha);
+    for (size_t i = 0; i < n; i++) {
+        // One write sets base0 from the low half and base1 from the high
+        interp_set_base_both(interp0, a[i] | ((uint32_t) b[i] << 16));
+        out[i] = interp_peek_lane_result(interp0, 1);
+    }
+    interp_restore(interp0, &save);
+}
+
+// A blend from 0
+void kern_scale8_interp(uint8_t *out, const uint8_t *in, size_t n, uint8_t scale) {
+    interp_hw_save_t save;
+
+    interp_save(interp0, &save);
+    kern_blend_setup(scale);
+    interp_set_base(interp0, 0, 0);
+    for (size_t i = 0; i < n; i++) {
+        interp_set_base(interp0, 1, in[i]);
+        out[i] = interp_peek_lane_result(interp0, 1);
+    }
+    interp_restore(interp0, &save);
+}
+#endif
@@ -0,0 +1,37 @@
+/**
+ * @brief Per-pixel kernels for the effect path
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Buffers are plain channel bytes, an rgb_t array of p pixels is 3 * p
+
+// Portable C, the reference for the interpolator versions
+void kern_lut8_c(uint8_t *out, const uint8_t *in, size_t n, const uint8_t *lut);
+void kern_lut16_c(uint16_t *out, const uint8_t *in, size_t n, const uint16_t *lut);
+void kern_lerp8_c(uint8_t *out, const uint8_t *a, const uint8_t *b, size_t n, uint8_t alpha);
+void kern_scale8_c(uint8_t *out, const uint8_t *in, size_t n, uint8_t scale);
+
+#if PICO_ON_DEVICE
+// interp0 of the calling core, saved and restored around each call
+void kern_lut8_interp(uint8_t *out, const uint8_t *in, size_t n, const uint8_t *lut);
+void kern_lut16_interp(uint16_t *out, const uint8_t *in, size_t n, const uint16_t *lut);
+void kern_lerp8_interp(uint8_t *out, const uint8_t *a, const uint8_t *b, size_t n, uint8_t alpha);
+void kern_scale8_interp(uint8_t *out, const uint8_t *in, size_t n, uint8_t scale);
+
+#define kern_lut8       kern_lut8_interp
+#define kern_lut16      kern_lut16_interp
+#define kern_lerp8      kern_lerp8_interp
+#define kern_scale8     kern_scale8_interp
+#else
+#define kern_lut8       kern_lut8_c
+#define kern_lut16      kern_lut16_c
+#define kern_lerp8      kern_lerp8_c
+#define kern_scale8     kern_scale8_c
+#endif
@@ -0,0 +1,81 @@
+/**
+ * @brief High-frequency dithered PWM output
+ *
+ * The slice wraps at DITHER_TOP with no clock divider, about 30 kHz from a
+ * 125 MHz system clock, and DMA walks a dither pattern through its compare
+ * register one value per period using the pwm_fade chaining. The pattern
+ * repeats every DITHER_STEPS periods, just under 2 kHz, and averages out to
+ * the full 16-bit level. Nothing runs on the CPU per period, a new level
+ * costs one pattern build and a pointer store.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "hardware/dma.h"
+
+#include "pwm_dither.h"
+
+/* Code */
+// Slice settings for dithered outputs, on top of whatever else is set
+void pwm_dither_config(pwm_config *config) {
+    pwm_config_set_clkdiv_int(config, 1);
+    pwm_config_set_wrap(config, DITHER_TOP);
+}
+
+// Both channels start at 0, the slice must already use pwm_dither_config()
+void pwm_dither_init(pwm_dither_t *dither, uint slice) {
+    dither->level[PWM_CHAN_A] = 0;
+    dither->level[PWM_CHAN_B] = 0;
+    for (uint i = 0; i < count_of(dither->tables); i++) {
+        for (uint j = 0; j < DITHER_STEPS; j++) {
+            dither->tables[i][j] = 0;
+        }
+    }
+    pwm_fade_init(&dither->fade, slice, dither->tables[0], DITHER_STEPS);
+}
+
+// A table is free if it is neither queued nor under the data channel's
+// read address. The address sits on the next table's first entry once a
+// pass ends, which at worst skips a table that is already finished.
+static uint32_t *pwm_dither_free_table(pwm_dither_t *dither) {
+    uintptr_t read = dma_hw->ch[dither->fade.data_chan].read_addr;
+
+    for (uint i = 0; i < count_of(dither->tables); i++) {
+        uint32_t *table = dither->tables[i];
+
+        if (table == dither->fade.next) {
+            continue;
+        }
+        if (read >= (uintptr_t) table && read < (uintptr_t) (table + DITHER_STEPS)) {
+            continue;
+        }
+        return table;
+    }
+    return NULL;
+}
+
+// From one context only. The new level starts at the end of the pattern
+// pass in progress.
+void pwm_dither_set(pwm_dither_t *dither, uint chan, uint16_t level) {
+    uint16_t cc[2][DITHER_STEPS];
+    uint32_t *table = pwm_dither_free_table(dither);
+
+    dither->level[chan] = level;
+    dither_pattern(cc[PWM_CHAN_A], dither->level[PWM_CHAN_A]);
+    dither_pattern(cc[PWM_CHAN_B], dither->level[PWM_CHAN_B]);
+    for (uint i = 0; i < DITHER_STEPS; i++) {
+        table[i] = PWM_FADE_LEVELS(cc[PWM_CHAN_A][i], cc[PWM_CHAN_B][i]);
+    }
+    pwm_fade_set_next(&dither->fade, table);
+}
+
+void pwm_dither_start(pwm_dither_t *dither) {
+    pwm_fade_start(&dither->fade);
+}
+
+void pwm_dither_stop(pwm_dither_t *dither) {
+    pwm_fade_stop(&dither->fade);
+}
@@ -0,0 +1,27 @@
+/**
+ * @brief High-frequency dithered PWM output
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include "hardware/pwm.h"
+
+#include "dither.h"
+#include "pwm_fade.h"
+
+typedef struct {
+    pwm_fade_t fade;
+
+    // One playing, one queued, one free to build into
+    uint32_t tables[3][DITHER_STEPS];
+    uint16_t level[2];
+} pwm_dither_t;
+
+void pwm_dither_config(pwm_config *config);
+void pwm_dither_init(pwm_dither_t *dither, uint slice);
+void pwm_dither_set(pwm_dither_t *dither, uint chan, uint16_t level);
+void pwm_dither_start(pwm_dither_t *dither);
+void pwm_dither_stop(pwm_dither_t *dither);
@@ -0,0 +1,89 @@
+/**
+ * @brief DMA-paced PWM fade engine
+ *
+ * A data channel paced by the slice's wrap DREQ writes one precomputed
+ * compare value per PWM period, and the compare register latches it at
+ * the next wrap. When the table runs out the data channel chains to a
+ * control channel, which reloads the data channel's read address from
+ * fade->next and so restarts it. A fade loops with no CPU work at all and
+ * no PWM_IRQ_WRAP, and switching to another table of the same length is a
+ * single pointer store that takes effect at the end of the current pass.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "hardware/dma.h"
+#include "hardware/pwm.h"
+
+#include "pwm_fade.h"
+
+/* Code */
+// Slice counters are left alone, enable slices together with
+// pwm_set_mask_enabled() to keep their fades in step
+void pwm_fade_init(pwm_fade_t *fade, uint slice, const uint32_t *table, size_t steps) {
+    fade->slice = slice;
+    fade->steps = steps;
+    fade->next = table;
+    fade->data_chan = dma_claim_unused_channel(true);
+    fade->ctrl_chan = dma_claim_unused_channel(true);
+
+    // Whole 32-bit writes, narrow writes to CC would be copied to both halves
+    dma_channel_config c = dma_channel_get_default_config(fade->data_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pwm_get_dreq(slice));
+    channel_config_set_chain_to(&c, fade->ctrl_chan);
+    dma_channel_configure(fade->data_chan, &c, &pwm_hw->slice[slice].cc, table, steps, false);
+
+    c = dma_channel_get_default_config(fade->ctrl_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, false);
+    dma_channel_configure(fade->ctrl_chan, &c, &dma_hw->ch[fade->data_chan].al3_read_addr_trig,
+                          &fade->next, 1, false);
+}
+
+// The first value goes out at the slice's first wrap
+void pwm_fade_start(pwm_fade_t *fade) {
+    dma_channel_start(fade->ctrl_chan);
+}
+
+// Aborting the data channel can still fire its chain, so point the chain
+// at itself first. The compare register keeps the last value written.
+void pwm_fade_stop(pwm_fade_t *fade) {
+    dma_channel_config c = dma_channel_get_default_config(fade->data_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pwm_get_dreq(fade->slice));
+    channel_config_set_chain_to(&c, fade->data_chan);
+    dma_channel_set_config(fade->data_chan, &c, false);
+
+    dma_channel_abort(fade->ctrl_chan);
+    dma_channel_abort(fade->data_chan);
+}
+
+// Safe from any context, tables must be fade->steps long
+void pwm_fade_set_next(pwm_fade_t *fade, const uint32_t *table) {
+    fade->next = table;
+}
+
+// One breath on channel chan, 0 up to full and back to 0 with the same
+// squared curve the wrap interrupt used. The other channel's half of each
+// entry is kept, so tables for A and B can be built into one.
+void pwm_fade_breath(uint32_t *table, size_t steps, uint chan) {
+    size_t half = steps / 2;
+    uint shift = chan == PWM_CHAN_B ? 16 : 0;
+
+    for (size_t i = 0; i < steps; i++) {
+        size_t phase = i < half ? i : steps - 1 - i;
+        uint32_t fade = half > 1 ? phase * 255 / (half - 1) : 0;
+
+        fade = MIN(fade, 255);
+        table[i] = (table[i] & ~(0xFFFFu << shift)) | ((fade * fade) << shift);
+    }
+}
@@ -0,0 +1,33 @@
+/**
+ * @brief DMA-paced PWM fade engine
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+
+// Both channels of a slice share one compare register, A in the low half
+#define PWM_FADE_LEVELS(a, b)   ((uint32_t) (a) | ((uint32_t) (b) << 16))
+
+typedef struct {
+    uint slice;
+    int data_chan;
+    int ctrl_chan;
+    size_t steps;
+
+    // Table the control channel loads at the end of each pass
+    const uint32_t *volatile next;
+} pwm_fade_t;
+
+void pwm_fade_init(pwm_fade_t *fade, uint slice, const uint32_t *table, size_t steps);
+void pwm_fade_start(pwm_fade_t *fade);
+void pwm_fade_stop(pwm_fade_t *fade);
+void pwm_fade_set_next(pwm_fade_t *fade, const uint32_t *table);
+
+void pwm_fade_breath(uint32_t *table, size_t steps, uint chan);
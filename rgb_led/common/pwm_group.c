@@ -0,0 +1,106 @@
+/**
+ * @brief PWM channel manager with per-slice atomic updates
+ *
+ * Maps up to 16 outputs onto the 8 slices. Levels are staged in a shadow
+ * copy of each slice's compare register and a commit writes every changed
+ * slice with one 32-bit store, both channels at once. The hardware
+ * double-buffers CC and latches it at wrap, so an update can never glitch
+ * a period. Groups start and stop with one write to the enable register
+ * after their counters are zeroed, so their slices stay phase-aligned.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "pwm_group.h"
+
+/* Code */
+// Every slice an output lands on gets config, left disabled
+void pwm_group_init(pwm_group_t *group, const pwm_config *config) {
+    group->num_outputs = 0;
+    group->dirty = 0;
+    group->slices = 0;
+    group->lead_slice = -1;
+    group->config = *config;
+    group->top = config->top;
+    group->writes = 0;
+    group->updates = 0;
+    group->commits = 0;
+    for (int slice = 0; slice < PWM_GROUP_SLICES; slice++) {
+        group->cc[slice] = 0;
+    }
+}
+
+// Returns the output's index, or -1 when the group is full
+int pwm_group_add(pwm_group_t *group, uint gpio) {
+    if (group->num_outputs == PWM_GROUP_MAX_OUTPUTS) {
+        return -1;
+    }
+
+    pwm_output_t *out = &group->outputs[group->num_outputs];
+    out->gpio = gpio;
+    out->slice = pwm_gpio_to_slice_num(gpio);
+    out->chan = pwm_gpio_to_channel(gpio);
+
+    if (!(group->slices & (1u << out->slice))) {
+        pwm_init(out->slice, &group->config, false);
+        group->slices |= 1u << out->slice;
+        if (group->lead_slice < 0) {
+            group->lead_slice = out->slice;
+        }
+    }
+    gpio_set_function(gpio, GPIO_FUNC_PWM);
+    return group->num_outputs++;
+}
+
+// Staged only, nothing reaches the hardware until pwm_group_commit()
+void pwm_group_set(pwm_group_t *group, int output, uint16_t level) {
+    const pwm_output_t *out = &group->outputs[output];
+    uint shift = out->chan == PWM_CHAN_B ? 16 : 0;
+    uint32_t cc = (group->cc[out->slice] & ~(0xFFFFu << shift)) | ((uint32_t) level << shift);
+
+    if (cc != group->cc[out->slice]) {
+        group->cc[out->slice] = cc;
+        group->dirty |= 1u << out->slice;
+        group->updates++;
+    }
+}
+
+void pwm_group_commit(pwm_group_t *group) {
+    if (!group->dirty) {
+        return;
+    }
+
+    // A commit takes well under a microsecond, only one close to the wrap
+    // could be split across two periods
+    if (group->top > 2 * PWM_GROUP_WRAP_GUARD && (pwm_hw->en & (1u << group->lead_slice))) {
+        while (pwm_get_counter(group->lead_slice) + PWM_GROUP_WRAP_GUARD > group->top) {
+            tight_loop_contents();
+        }
+    }
+
+    for (uint slice = 0; slice < PWM_GROUP_SLICES; slice++) {
+        if (group->dirty & (1u << slice)) {
+            pwm_hw->slice[slice].cc = group->cc[slice];
+            group->writes++;
+        }
+    }
+    group->dirty = 0;
+    group->commits++;
+}
+
+// Commit before starting so the first period already has the levels
+void pwm_group_start(pwm_group_t *group) {
+    for (uint slice = 0; slice < PWM_GROUP_SLICES; slice++) {
+        if (group->slices & (1u << slice)) {
+            pwm_hw->slice[slice].ctr = 0;
+        }
+    }
+    pwm_set_mask_enabled(pwm_hw->en | group->slices);
+}
+
+void pwm_group_stop(pwm_group_t *group) {
+    pwm_set_mask_enabled(pwm_hw->en & ~group->slices);
+}
@@ -0,0 +1,52 @@
+/**
+ * @brief PWM channel manager with per-slice atomic updates
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+#include "hardware/pwm.h"
+
+#define PWM_GROUP_SLICES        8
+#define PWM_GROUP_MAX_OUTPUTS   (2 * PWM_GROUP_SLICES)
+
+// Commits this close to the lead slice's wrap wait for it to pass, so
+// every slice of a commit latches on the same period
+#define PWM_GROUP_WRAP_GUARD    64
+
+typedef struct {
+    uint8_t gpio;
+    uint8_t slice;
+    uint8_t chan;
+} pwm_output_t;
+
+typedef struct {
+    pwm_output_t outputs[PWM_GROUP_MAX_OUTPUTS];
+    uint num_outputs;
+
+    // Shadow compare values, A in the low half like the CC register
+    uint32_t cc[PWM_GROUP_SLICES];
+    uint32_t dirty;         // Slices with uncommitted changes
+    uint32_t slices;        // Slices owned by the group
+    int lead_slice;
+    pwm_config config;
+    uint16_t top;
+
+    // Register writes issued, and channel updates they carried
+    uint32_t writes;
+    uint32_t updates;
+    uint32_t commits;
+} pwm_group_t;
+
+void pwm_group_init(pwm_group_t *group, const pwm_config *config);
+int pwm_group_add(pwm_group_t *group, uint gpio);
+void pwm_group_set(pwm_group_t *group, int output, uint16_t level);
+void pwm_group_commit(pwm_group_t *group);
+void pwm_group_start(pwm_group_t *group);
+void pwm_group_stop(pwm_group_t *group);
@@ -0,0 +1,44 @@
+/**
+ * @brief Integer color engine, HSV to RGB, gamma and calibration
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdint.h>
+
+// Hue covers the whole circle in 16 bits, red at 0
+typedef struct {
+    uint16_t h;
+    uint8_t s;
+    uint8_t v;
+} hsv_t;
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} rgb_t;
+
+// PWM compare levels
+typedef struct {
+    uint16_t r;
+    uint16_t g;
+    uint16_t b;
+} rgb16_t;
+
+// Gamma with each channel's calibration folded in, one lookup per channel
+typedef struct {
+    uint16_t lut[3][256];
+} rgb_calib_t;
+
+// Full scale for rgb_calib_init(), 1.0 in Q16
+#define RGB_CALIB_ONE   65536
+
+extern const uint16_t rgb_gamma_lut[256];
+
+rgb_t rgb_from_hsv(hsv_t hsv);
+void rgb_calib_init(rgb_calib_t *cal, uint32_t r_scale, uint32_t g_scale, uint32_t b_scale);
+rgb16_t rgb_calib_apply(const rgb_calib_t *cal, rgb_t c);
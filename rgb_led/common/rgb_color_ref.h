@@ -0,0 +1,46 @@
+/**
+ * @brief Float reference for the integer color engine
+ *
+ * Straight textbook formulas, only used to check and benchmark
+ * rgb_color.c on the host and on target.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include "rgb_color.h"
+
+static inline uint8_t rgb_ref_round(float x) {
+    return (uint8_t) (x + 0.5f);
+}
+
+static inline rgb_t rgb_from_hsv_ref(hsv_t hsv) {
+    float h = hsv.h * 6.0f / 65536.0f;
+    float s = hsv.s / 255.0f;
+    float v = hsv.v;
+    int sector = (int) h;
+    float f = h - sector;
+    uint8_t p = rgb_ref_round(v * (1.0f - s));
+    uint8_t q = rgb_ref_round(v * (1.0f - s * f));
+    uint8_t t = rgb_ref_round(v * (1.0f - s * (1.0f - f)));
+
+    switch (sector) {
+        case 0:  return (rgb_t) { hsv.v, t, p };
+        case 1:  return (rgb_t) { q, hsv.v, p };
+        case 2:  return (rgb_t) { p, hsv.v, t };
+        case 3:  return (rgb_t) { p, q, hsv.v };
+        case 4:  return (rgb_t) { t, p, hsv.v };
+        default: return (rgb_t) { hsv.v, p, q };
+    }
+}
+
+// CIE 1976 lightness to luminance, scale is the calibration as a fraction
+static inline uint16_t rgb_gamma_ref(uint8_t x, float scale) {
+    float l = x * 100.0f / 255.0f;
+    float y = l > 8.0f ? (l + 16.0f) / 116.0f : 0.0f;
+
+    y = l > 8.0f ? y * y * y : l / 903.3f;
+    return (uint16_t) (y * scale * 65535.0f + 0.5f);
+}
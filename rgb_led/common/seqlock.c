@@ -0,0 +1,61 @@
+/**
+ * @brief Lock-free double-buffered parameter block
+ *
+ * A sequence-counted latch: the writer flips readers over to the second
+ * copy while it updates the first, then back while it updates the second,
+ * so there is always one stable copy and a reader never waits on a write
+ * in progress. That makes it safe for an ISR to read a block whose writer
+ * it has interrupted, with no masking on either side. A reader only loops
+ * if a write completes a flip during its copy, which needs a writer that
+ * preempts the reader or runs on the other core. One writer per block.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include <string.h>
+
+#include "seqlock.h"
+
+/* Code */
+// copies holds 2 * size bytes and stays owned by the lock
+void seqlock_init(seqlock_t *lock, void *copies, size_t size, const void *initial) {
+    lock->seq = 0;
+    lock->size = size;
+    lock->copies = copies;
+    memcpy(lock->copies, initial, size);
+    memcpy(lock->copies + size, initial, size);
+}
+
+void seqlock_write(seqlock_t *lock, const void *value) {
+    uint32_t seq = lock->seq;
+
+    // Readers to copy 1, update copy 0
+    __atomic_store_n(&lock->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(lock->copies, value, lock->size);
+
+    // Readers back to copy 0, update copy 1
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&lock->seq, seq + 2, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(lock->copies + lock->size, value, lock->size);
+
+    // Copy 1 complete before the next write sends readers to it
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+// Returns the sequence the copy was taken at
+uint32_t seqlock_read(seqlock_t *lock, void *value) {
+    uint32_t seq;
+
+    do {
+        seq = __atomic_load_n(&lock->seq, __ATOMIC_ACQUIRE);
+        memcpy(value, lock->copies + (seq & 1) * lock->size, lock->size);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (__atomic_load_n(&lock->seq, __ATOMIC_RELAXED) != seq);
+
+    return seq;
+}
@@ -0,0 +1,26 @@
+/**
+ * @brief Lock-free double-buffered parameter block
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t seq;      // Low bit picks the copy readers use
+    size_t size;
+    uint8_t *copies;            // Two copies, size bytes each
+} seqlock_t;
+
+void seqlock_init(seqlock_t *lock, void *copies, size_t size, const void *initial);
+void seqlock_write(seqlock_t *lock, const void *value);
+uint32_t seqlock_read(seqlock_t *lock, void *value);
+
+// Bumped by two for each write, compare against what seqlock_read() returned
+static inline uint32_t seqlock_seq(const seqlock_t *lock) {
+    return __atomic_load_n(&lock->seq, __ATOMIC_ACQUIRE);
+}
@@ -0,0 +1,160 @@
+/**
+ * @brief PIO and DMA driven WS2812/SK6812 strips
+ *
+ * Each strip has its own state machine and DMA channel and two encoded
+ * frames. The caller draws into the back frame and swaps. A swap is taken
+ * at the strip's vsync, when the previous frame has been sent and latched:
+ * the DMA completion interrupt arms an alarm for the drain and reset time
+ * and the alarm starts the next frame, so the CPU only runs twice per
+ * frame. 1000 GRB pixels take 30 ms on the wire, 32 fps, and strips on
+ * other state machines send in parallel.
+ *
+ * With every alarm slot taken the interrupt can't arm one, it notes when
+ * the frame latches instead and ws2812_swap() or ws2812_wait() starts the
+ * next frame once that time has passed.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+
+#include "ws2812.h"
+#include "ws2812.pio.h"
+
+/* Globals */
+static ws2812_strip_t *ws2812_strips[WS2812_MAX_STRIPS];
+static uint ws2812_num_strips;
+static int ws2812_offset[2] = { -1, -1 };
+
+/* Prototypes */
+static void ws2812_dma_irq(void);
+static int64_t ws2812_latched(alarm_id_t id, void *user_data);
+
+/* Code */
+// Interrupts off or from the driver's own handlers
+static void ws2812_kick(ws2812_strip_t *strip) {
+    if (!strip->pending) {
+        strip->busy = false;
+        return;
+    }
+
+    strip->front ^= 1;
+    strip->pending = false;
+    strip->busy = true;
+    dma_channel_transfer_from_buffer_now(strip->dma_chan, strip->frames[strip->front],
+                                         strip->num_pixels);
+}
+
+// Frames are caller owned, num_pixels words each. The strip stays dark
+// until the first swap.
+void ws2812_init(ws2812_strip_t *strip, PIO pio, uint pin, uint32_t *frame0, uint32_t *frame1,
+                 size_t num_pixels, bool rgbw) {
+    uint index = pio_get_index(pio);
+
+    strip->pio = pio;
+    strip->sm = pio_claim_unused_sm(pio, true);
+    strip->num_pixels = num_pixels;
+    strip->rgbw = rgbw;
+    strip->frames[0] = frame0;
+    strip->frames[1] = frame1;
+    strip->front = 1;           // Draw into frame0 first
+    strip->pending = false;
+    strip->busy = false;
+    strip->latch_us = 0;
+    strip->frames_sent = 0;
+    strip->alarm_misses = 0;
+
+    if (ws2812_offset[index] < 0) {
+        ws2812_offset[index] = pio_add_program(pio, &ws2812_program);
+    }
+    ws2812_program_init(pio, strip->sm, ws2812_offset[index], pin, rgbw ? 32 : 24);
+
+    strip->dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(strip->dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(pio, strip->sm, true));
+    dma_channel_configure(strip->dma_chan, &c, &pio->txf[strip->sm], NULL, 0, false);
+
+    if (ws2812_num_strips == 0) {
+        irq_add_shared_handler(DMA_IRQ_0, ws2812_dma_irq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+    }
+    hard_assert(ws2812_num_strips < WS2812_MAX_STRIPS);
+    ws2812_strips[ws2812_num_strips++] = strip;
+    dma_channel_set_irq0_enabled(strip->dma_chan, true);
+}
+
+// Free to draw into until the next swap
+uint32_t *ws2812_back(ws2812_strip_t *strip) {
+    return strip->frames[strip->front ^ 1];
+}
+
+void ws2812_encode(ws2812_strip_t *strip, const rgb_t *pixels, uint16_t scale) {
+    if (strip->rgbw) {
+        ws2812_encode_grbw(ws2812_back(strip), pixels, strip->num_pixels, scale);
+    } else {
+        ws2812_encode_grb(ws2812_back(strip), pixels, strip->num_pixels, scale);
+    }
+}
+
+// Starts the next frame for an interrupt that had no alarm to do it
+static void ws2812_poll(ws2812_strip_t *strip) {
+    uint32_t save = save_and_disable_interrupts();
+    if (strip->latch_us && time_us_64() >= strip->latch_us) {
+        strip->latch_us = 0;
+        ws2812_kick(strip);
+    }
+    restore_interrupts(save);
+}
+
+// Publishes the back frame and returns once it is on the wire, so the new
+// back frame is the one that has just finished sending
+void ws2812_swap(ws2812_strip_t *strip) {
+    strip->pending = true;
+
+    uint32_t save = save_and_disable_interrupts();
+    if (!strip->busy) {
+        ws2812_kick(strip);
+    }
+    restore_interrupts(save);
+
+    while (strip->pending) {
+        ws2812_poll(strip);
+    }
+}
+
+// Until the strip has latched its last frame
+void ws2812_wait(ws2812_strip_t *strip) {
+    while (strip->busy) {
+        ws2812_poll(strip);
+    }
+}
+
+/* Interrupt handlers */
+static void ws2812_dma_irq(void) {
+    for (uint i = 0; i < ws2812_num_strips; i++) {
+        ws2812_strip_t *strip = ws2812_strips[i];
+
+        if (dma_channel_get_irq0_status(strip->dma_chan)) {
+            dma_channel_acknowledge_irq0(strip->dma_chan);
+            strip->frames_sent++;
+            if (add_alarm_in_us(WS2812_LATCH_US, ws2812_latched, strip, true) < 0) {
+                strip->latch_us = time_us_64() + WS2812_LATCH_US;
+                strip->alarm_misses++;
+            }
+        }
+    }
+}
+
+// Vsync, the frame has latched
+static int64_t ws2812_latched(alarm_id_t id, void *user_data) {
+    ws2812_kick(user_data);
+    return 0;
+}
@@ -0,0 +1,55 @@
+/**
+ * @brief PIO and DMA driven WS2812/SK6812 strips
+ *
+ * Sending takes no CPU beyond two interrupts a frame, but ws2812_swap()
+ * busy-waits for the strip's vsync, up to a whole frame on the wire and
+ * its latch, about 30 ms for 1000 pixels. Draw the next frame before
+ * swapping, or call it from a task that has nothing else to do.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+
+#include "rgb_color.h"
+#include "ws2812_encode.h"
+
+#define WS2812_MAX_STRIPS   8       // Four state machines on each PIO
+
+// After the last DMA write the FIFO and shift register still hold up to
+// nine pixels, then the line must stay low for the reset time
+#define WS2812_DRAIN_US     (9 * 40)
+#define WS2812_RESET_US     300
+#define WS2812_LATCH_US     (WS2812_DRAIN_US + WS2812_RESET_US)
+
+typedef struct {
+    PIO pio;
+    uint sm;
+    int dma_chan;
+    size_t num_pixels;
+    bool rgbw;
+
+    // Encoded frames, one on the wire and one being drawn
+    uint32_t *frames[2];
+    volatile uint front;
+    volatile bool pending;      // Back frame published, waiting for vsync
+    volatile bool busy;         // Sending or latching
+    volatile uint64_t latch_us; // No alarm was free, kick from swap or wait at this time
+
+    volatile uint32_t frames_sent;
+    volatile uint32_t alarm_misses;
+} ws2812_strip_t;
+
+void ws2812_init(ws2812_strip_t *strip, PIO pio, uint pin, uint32_t *frame0, uint32_t *frame1,
+                 size_t num_pixels, bool rgbw);
+uint32_t *ws2812_back(ws2812_strip_t *strip);
+void ws2812_encode(ws2812_strip_t *strip, const rgb_t *pixels, uint16_t scale);
+void ws2812_swap(ws2812_strip_t *strip);
+void ws2812_wait(ws2812_strip_t *strip);
@@ -0,0 +1,50 @@
+/**
+ * @brief WS2812/SK6812 pixel encoding
+ *
+ * Packs RGB pixels into the words the ws2812 PIO program shifts out MSB
+ * first: green, red, blue from bit 31 down, then white for GRBW strips.
+ * The global brightness scale is applied on the way, scale / 256.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "ws2812_encode.h"
+
+/* Code */
+void ws2812_encode_grb(uint32_t *out, const rgb_t *in, size_t n, uint16_t scale) {
+    if (scale >= WS2812_SCALE_FULL) {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = ((uint32_t) in[i].g << 24) | ((uint32_t) in[i].r << 16)
+                   | ((uint32_t) in[i].b << 8);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        uint32_t g = (in[i].g * scale) >> 8;
+        uint32_t r = (in[i].r * scale) >> 8;
+        uint32_t b = (in[i].b * scale) >> 8;
+
+        out[i] = (g << 24) | (r << 16) | (b << 8);
+    }
+}
+
+// The white die takes the part common to all three
+void ws2812_encode_grbw(uint32_t *out, const rgb_t *in, size_t n, uint16_t scale) {
+    scale = scale > WS2812_SCALE_FULL ? WS2812_SCALE_FULL : scale;
+
+    for (size_t i = 0; i < n; i++) {
+        uint32_t w = in[i].r < in[i].g ? in[i].r : in[i].g;
+        w = in[i].b < w ? in[i].b : w;
+
+        uint32_t g = ((in[i].g - w) * scale) >> 8;
+        uint32_t r = ((in[i].r - w) * scale) >> 8;
+        uint32_t b = ((in[i].b - w) * scale) >> 8;
+        w = (w * scale) >> 8;
+
+        out[i] = (g << 24) | (r << 16) | (b << 8) | w;
+    }
+}
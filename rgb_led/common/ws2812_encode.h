@@ -0,0 +1,19 @@
+/**
+ * @brief WS2812/SK6812 pixel encoding
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "rgb_color.h"
+
+// Full brightness for the scale argument
+#define WS2812_SCALE_FULL   256
+
+void ws2812_encode_grb(uint32_t *out, const rgb_t *in, size_t n, uint16_t scale);
+void ws2812_encode_grbw(uint32_t *out, const rgb_t *in, size_t n, uint16_t scale);
@@ -12,6 +12,11 @@
 #define BLUE_PIN        18
 #define LED_PIN         25
 
+// 1 streams precomputed fades into the PWM compare registers by DMA with no
+// interrupts at all, 0 steps the fade from the wrap interrupt
+#define FADE_DMA        1
+#define FADE_STEPS      512     // One breath, 0 -> 255 -> 0, one step per wrap
+
 /* Includes */
 #include <stdio.h>
 #include "pico/stdlib.h"
@@ -19,13 +24,25 @@
 #include "hardware/irq.h"
 #include "hardware/pwm.h"
 
+#include "pwm_fade.h"
+
 /* Globals */
 uint slice_num_red;
 uint slice_num_green;
 uint slice_num_blue;
 
+#if FADE_DMA
+// One pass of each table is a whole RED -> GREEN -> BLUE cycle. Red and
+// green are channels A and B of one slice and share a table.
+static uint32_t fade_table_rg[3 * FADE_STEPS];
+static uint32_t fade_table_b[3 * FADE_STEPS];
+static pwm_fade_t fade_rg;
+static pwm_fade_t fade_b;
+#endif
+
 /* Prototypes */
 void on_pwm_wrap(void);
+void fade_dma_init(void);
 void hardware_init(void);
 
 /* Code */
@@ -86,6 +103,20 @@ void on_pwm_wrap() {
     }
 }
 
+#if FADE_DMA
+void fade_dma_init(void)
+{
+    pwm_fade_breath(&fade_table_rg[0], FADE_STEPS, pwm_gpio_to_channel(RED_PIN));
+    pwm_fade_breath(&fade_table_rg[FADE_STEPS], FADE_STEPS, pwm_gpio_to_channel(GREEN_PIN));
+    pwm_fade_breath(&fade_table_b[2 * FADE_STEPS], FADE_STEPS, pwm_gpio_to_channel(BLUE_PIN));
+
+    pwm_fade_init(&fade_rg, slice_num_red, fade_table_rg, count_of(fade_table_rg));
+    pwm_fade_init(&fade_b, slice_num_blue, fade_table_b, count_of(fade_table_b));
+    pwm_fade_start(&fade_rg);
+    pwm_fade_start(&fade_b);
+}
+#endif
+
 void hardware_init(void)
 {
     // GPIO pin 16
@@ -94,8 +125,10 @@ void hardware_init(void)
 
     gpio_set_function(RED_PIN, GPIO_FUNC_PWM);
     slice_num_red = pwm_gpio_to_slice_num(RED_PIN);
+#if !FADE_DMA
     pwm_clear_irq(slice_num_red);
     pwm_set_irq_enabled(slice_num_red, true);
+#endif
 
     // GPIO pin 17
     gpio_init(GREEN_PIN);
@@ -103,8 +136,10 @@ void hardware_init(void)
 
     gpio_set_function(GREEN_PIN, GPIO_FUNC_PWM);
     slice_num_green = pwm_gpio_to_slice_num(GREEN_PIN);
+#if !FADE_DMA
     pwm_clear_irq(slice_num_green);
     pwm_set_irq_enabled(slice_num_green, true);
+#endif
 
     // GPIO pin 18
     gpio_init(BLUE_PIN);
@@ -112,18 +147,30 @@ void hardware_init(void)
 
     gpio_set_function(BLUE_PIN, GPIO_FUNC_PWM);
     slice_num_blue = pwm_gpio_to_slice_num(BLUE_PIN);
+#if !FADE_DMA
     pwm_clear_irq(slice_num_blue);
     pwm_set_irq_enabled(slice_num_blue, true);
+#endif
 
     // General PWM setup
-    irq_set_exclusive_handler(PWM_IRQ_WRAP, on_pwm_wrap);
-    irq_set_enabled(PWM_IRQ_WRAP, true);
-
     pwm_config config = pwm_get_default_config();
     pwm_config_set_clkdiv(&config, 4.f);
 
+#if FADE_DMA
+    // Every slice runs, the tables hold the idle colors at zero. Counters
+    // start together so both tables stay on the same step.
+    pwm_init(slice_num_red, &config, false);
+    pwm_init(slice_num_green, &config, false);
+    pwm_init(slice_num_blue, &config, false);
+    fade_dma_init();
+    pwm_set_mask_enabled((1u << slice_num_red) | (1u << slice_num_green) | (1u << slice_num_blue));
+#else
+    irq_set_exclusive_handler(PWM_IRQ_WRAP, on_pwm_wrap);
+    irq_set_enabled(PWM_IRQ_WRAP, true);
+
     // Assume start with RED pin, init others to disabled
     pwm_init(slice_num_green, &config, false);
     pwm_init(slice_num_blue, &config, false);
     pwm_init(slice_num_red, &config, true);
+#endif
 }
\ No newline at end of file
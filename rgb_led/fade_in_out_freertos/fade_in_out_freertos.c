@@ -13,6 +13,11 @@
 
 #define HEARTBEAT_DELAY 500
 
+// 1 streams precomputed fades into the PWM compare registers by DMA with no
+// interrupts at all, 0 steps the fade from the wrap interrupt
+#define FADE_DMA        1
+#define FADE_STEPS      512     // One breath, 0 -> 255 -> 0, one step per wrap
+
 
 /* Includes */
 #include <stdio.h>
@@ -27,6 +32,8 @@
 #include "hardware/irq.h"
 #include "hardware/pwm.h"
 
+#include "pwm_fade.h"
+
 
 /* Globals */
 static uint slice_num_red;
@@ -39,10 +46,23 @@ static bool going_up = false;
 static uint pin = RED_PIN; // Start on RED PIN
 static bool change_color = false;
 
+#if FADE_DMA
+// One breath per table. A new table only starts at the end of the current
+// breath, where the wrap interrupt used to change color. Red and green are
+// channels A and B of one slice, blue has its own.
+static uint32_t fade_table_red[FADE_STEPS];
+static uint32_t fade_table_green[FADE_STEPS];
+static uint32_t fade_table_blue[FADE_STEPS];
+static uint32_t fade_table_off[FADE_STEPS];
+static pwm_fade_t fade_rg;
+static pwm_fade_t fade_b;
+#endif
+
 
 /* Prototypes */
 void gpio_int_callback(uint gpio, uint32_t events_unused);
 void on_pwm_wrap(void);
+void fade_dma_init(void);
 void hardware_init(void);
 void heartbeat(void* unused);
 
@@ -65,12 +85,37 @@ int main()
 }
 
 /* Interrupt handlers */
+#if FADE_DMA
+// Only queues the next tables, the DMA picks them up after this breath
+void gpio_int_callback(uint gpio, uint32_t events_unused) 
+{
+    // RED -> GREEN -> BLUE -> wrap and cont...
+    switch (pin) {
+        case RED_PIN:
+            pin = GREEN_PIN;
+            pwm_fade_set_next(&fade_rg, fade_table_green);
+            pwm_fade_set_next(&fade_b, fade_table_off);
+            break;
+        case GREEN_PIN:
+            pin = BLUE_PIN;
+            pwm_fade_set_next(&fade_rg, fade_table_off);
+            pwm_fade_set_next(&fade_b, fade_table_blue);
+            break;
+        case BLUE_PIN:
+            pin = RED_PIN;
+            pwm_fade_set_next(&fade_rg, fade_table_red);
+            pwm_fade_set_next(&fade_b, fade_table_off);
+            break;
+    }
+}
+#else
 void gpio_int_callback(uint gpio, uint32_t events_unused) 
 {
     irq_set_enabled(PWM_IRQ_WRAP, false);
     change_color = true;
     irq_set_enabled(PWM_IRQ_WRAP, true);
 }
+#endif
 
 void on_pwm_wrap() {
     // Clear interrupt
@@ -133,6 +178,20 @@ void heartbeat(void* notUsed)
 
 
 /* Initialization functions */
+#if FADE_DMA
+void fade_dma_init(void)
+{
+    pwm_fade_breath(fade_table_red, FADE_STEPS, pwm_gpio_to_channel(RED_PIN));
+    pwm_fade_breath(fade_table_green, FADE_STEPS, pwm_gpio_to_channel(GREEN_PIN));
+    pwm_fade_breath(fade_table_blue, FADE_STEPS, pwm_gpio_to_channel(BLUE_PIN));
+
+    pwm_fade_init(&fade_rg, slice_num_red, fade_table_red, FADE_STEPS);
+    pwm_fade_init(&fade_b, slice_num_blue, fade_table_off, FADE_STEPS);
+    pwm_fade_start(&fade_rg);
+    pwm_fade_start(&fade_b);
+}
+#endif
+
 void hardware_init(void)
 {
     printf("hardware init\n");
@@ -151,8 +210,10 @@ void hardware_init(void)
 
     gpio_set_function(RED_PIN, GPIO_FUNC_PWM);
     slice_num_red = pwm_gpio_to_slice_num(RED_PIN);
+#if !FADE_DMA
     pwm_clear_irq(slice_num_red);
     pwm_set_irq_enabled(slice_num_red, true);
+#endif
 
     // GPIO pin 17
     printf("init GREEN_PIN\n");
@@ -161,8 +222,10 @@ void hardware_init(void)
 
     gpio_set_function(GREEN_PIN, GPIO_FUNC_PWM);
     slice_num_green = pwm_gpio_to_slice_num(GREEN_PIN);
+#if !FADE_DMA
     pwm_clear_irq(slice_num_green);
     pwm_set_irq_enabled(slice_num_green, true);
+#endif
 
     // GPIO pin 18
     printf("init BLUE_PIN\n");
@@ -171,19 +234,31 @@ void hardware_init(void)
 
     gpio_set_function(BLUE_PIN, GPIO_FUNC_PWM);
     slice_num_blue = pwm_gpio_to_slice_num(BLUE_PIN);
+#if !FADE_DMA
     pwm_clear_irq(slice_num_blue);
     pwm_set_irq_enabled(slice_num_blue, true);
+#endif
 
     // General PWM setup
     printf("init PWM\n");
-    irq_set_exclusive_handler(PWM_IRQ_WRAP, on_pwm_wrap);
-    irq_set_enabled(PWM_IRQ_WRAP, true);
-
     pwm_config config = pwm_get_default_config();
     pwm_config_set_clkdiv(&config, 2.f);
 
+#if FADE_DMA
+    // Every slice runs, the off table holds idle colors at zero. Counters
+    // start together so both fades stay on the same step.
+    pwm_init(slice_num_red, &config, false);
+    pwm_init(slice_num_green, &config, false);
+    pwm_init(slice_num_blue, &config, false);
+    fade_dma_init();
+    pwm_set_mask_enabled((1u << slice_num_red) | (1u << slice_num_green) | (1u << slice_num_blue));
+#else
+    irq_set_exclusive_handler(PWM_IRQ_WRAP, on_pwm_wrap);
+    irq_set_enabled(PWM_IRQ_WRAP, true);
+
     // Assume start with RED pin, init others to disabled
     pwm_init(slice_num_green, &config, false);
     pwm_init(slice_num_blue, &config, false);
     pwm_init(slice_num_red, &config, true);
+#endif
 }
\ No newline at end of file
@@ -11,9 +11,19 @@
 #define RED_PIN                 16
 #define GREEN_PIN               17
 #define BLUE_PIN                18
+#define ENCODER_A_PIN           10  // B on 11
+
+// Brightness units per accelerated encoder detent, out of 255
+#define ENCODER_FADE_STEP       2
 
 #define HEARTBEAT_DELAY 500
 
+// NVIC priorities, lower is more urgent. The wrap interrupt must not slip
+// a period, button edges only take a timestamp, USB can wait.
+#define PWM_IRQ_PRIORITY        0x40
+#define GPIO_IRQ_PRIORITY       0x80
+#define USB_IRQ_PRIORITY        0xC0
+
 
 /* Includes */
 #include <stdio.h>
@@ -28,35 +38,59 @@
 #include "hardware/irq.h"
 #include "hardware/pwm.h"
 
+#include "button.h"
+#include "encoder.h"
+#include "seqlock.h"
+
 
 /* Globals */
 static uint slice_num_red;
 static uint slice_num_green;
 static uint slice_num_blue;
 
-// LED PWM pulse variables
-static int fade = 0;
-static bool going_up = false;
+// Button state, only button_pressed() touches these
 static uint pin = RED_PIN; // Start on RED PIN
+static uint32_t presses = 0;
 static bool change_color = false;
 
+// Read by on_pwm_wrap() every period, brightness tracks the knob within
+// one wrap
+static encoder_t encoder;
+
+// What the buttons asked for, published whole by button_pressed() and
+// applied by on_pwm_wrap() at the next wrap. The brightness itself is
+// owned by on_pwm_wrap() since both the buttons and the encoder move it.
+typedef struct {
+    uint pin;
+    uint32_t presses;
+} led_params_t;
+
+static led_params_t led_params_copies[2];
+static seqlock_t led_params;
+
 
 /* Prototypes */
-void gpio_int_callback(uint gpio, uint32_t events_unused);
+void button_pressed(uint gpio, button_event_t event, uint64_t time_us);
 void on_pwm_wrap(void);
 void hardware_init(void);
 void heartbeat(void* unused);
+void buttons(void* unused);
 
 
 /* Code */
 int main()
 {
+    TaskHandle_t buttons_task;
+
     printf("program start\n");
     stdio_init_all();
-    hardware_init();
+    irq_set_priority(USBCTRL_IRQ, USB_IRQ_PRIORITY);
 
     printf("create tasks\n");
     xTaskCreate(heartbeat, "LED_Task", 256, NULL, 1, NULL);
+    xTaskCreate(buttons, "BUTTON_Task", 256, NULL, 2, &buttons_task);
+    button_init(buttons_task, GPIO_IRQ_PRIORITY);
+    hardware_init();
 
     printf("start scheduler\n");
     vTaskStartScheduler();
@@ -66,72 +100,106 @@ int main()
 }
 
 /* Interrupt handlers */
-void gpio_int_callback(uint gpio, uint32_t events_unused) 
+// The only place the PWM is touched after init
+void on_pwm_wrap() {
+    static led_params_t applied = { RED_PIN, 0 };
+    static uint32_t seen;
+    // LED PWM pulse variables
+    static int fade = 0;
+    static bool going_up = false;
+    int last_fade = fade;
+    led_params_t next = applied;
+
+    // Clear interrupt
+    pwm_clear_irq(pwm_gpio_to_slice_num(applied.pin));
+
+    if (seqlock_seq(&led_params) != seen) {
+        seen = seqlock_read(&led_params, &next);
+    }
+
+    // Each press steps 100 towards the end it is heading for, then turns
+    for (; applied.presses != next.presses; applied.presses++) {
+        if (going_up) {
+            fade += 100;
+            if (fade > 255) {
+                fade = 255;
+                going_up = false;
+            }
+        } else {
+            fade -= 100;
+            if (fade < 0) {
+                fade = 0;
+                going_up = true;
+            }
+        }
+    }
+
+    fade += encoder_delta(&encoder) * ENCODER_FADE_STEP;
+    fade = MAX(0, MIN(fade, 255));
+
+    if (next.pin != applied.pin) {
+        pwm_set_gpio_level(applied.pin, 0);
+        pwm_set_enabled(pwm_gpio_to_slice_num(applied.pin), false);
+        pwm_set_enabled(pwm_gpio_to_slice_num(next.pin), true);
+        applied.pin = next.pin;
+    } else if (fade == last_fade) {
+        return;
+    }
+
+    // Square fade for better ~aesthetics~
+    pwm_set_gpio_level(applied.pin, fade * fade);
+}
+
+/* Handler functions */
+// Runs in the button task, edges already debounced
+void button_pressed(uint gpio, button_event_t event, uint64_t time_us)
 {
-    irq_set_enabled(PWM_IRQ_WRAP, false);
     switch (gpio) {
         case CHANGE_COLOR_PIN:
             change_color = true;
             break;
         case INC_BRIGHTNESS_PIN:
-            if (going_up) {
-                fade += 100;
-                if (fade > 255) {
-                    fade = 255;
-                    going_up = false;
-                }
-            } else {
-                fade -= 100;
-                if (fade < 0) {
-                    fade = 0;
-                    going_up = true;
-                }
-            }
-
-            // Square fade for better ~aesthetics~
-            pwm_set_gpio_level(pin, fade * fade);
+            presses++;
 
             // Switch LED colors when completely faded
             if (change_color) {
-                pwm_set_gpio_level(pin, 0);
                 switch (pin) {
                     // RED -> GREEN -> BLUE -> wrap and cont...
                     case RED_PIN:
                         pin = GREEN_PIN;
-                        pwm_set_enabled(slice_num_red, false);
-                        pwm_set_enabled(slice_num_green, true);
                         break;
                     case GREEN_PIN:
                         pin = BLUE_PIN;
-                        pwm_set_enabled(slice_num_green, false);
-                        pwm_set_enabled(slice_num_blue, true);
                         break;
                     case BLUE_PIN:
                         pin = RED_PIN;
-                        pwm_set_enabled(slice_num_blue, false);
-                        pwm_set_enabled(slice_num_red, true);
                         break;
                 }
                 change_color = false;
             }
+
+            seqlock_write(&led_params, &(led_params_t) { pin, presses });
             break;
         default:
             assert(false);
             break;
     }
-    irq_set_enabled(PWM_IRQ_WRAP, true);
 }
 
-void on_pwm_wrap() {
-    // Clear interrupt
-    pwm_clear_irq(pwm_gpio_to_slice_num(pin));
+void buttons(void* notUsed)
+{
+    while (true) {
+        ulTaskNotifyTakeIndexed(BUTTON_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+        button_dispatch();
+    }
 }
 
-/* Handler functions */
 void heartbeat(void* notUsed)
 {   
     while (true) {
-        printf("hb-tick: %d\n", HEARTBEAT_DELAY);
+        printf("hb-tick: %d, buttons: %lu edges, %lu bounces, %lu dropped, worst isr %lu us\n",
+               HEARTBEAT_DELAY, button_stats.edges, button_stats.bounces, button_stats.dropped,
+               button_stats.isr_max_us);
         gpio_put(PICO_DEFAULT_LED_PIN, 1);
         vTaskDelay(HEARTBEAT_DELAY);
         gpio_put(PICO_DEFAULT_LED_PIN, 0);
@@ -145,19 +213,21 @@ void hardware_init(void)
 {
     printf("hardware init\n");
 
+    // Before any interrupt can read or write it
+    seqlock_init(&led_params, led_params_copies, sizeof(led_params_t),
+                 &(led_params_t) { RED_PIN, 0 });
+
     // GPIO CHANGE_COLOR pin
     printf("init CHANGE_COLOR_PIN\n");
-    gpio_init(CHANGE_COLOR_PIN);
-    gpio_pull_up(CHANGE_COLOR_PIN);
-    gpio_set_dir(CHANGE_COLOR_PIN, GPIO_IN);
-    gpio_set_irq_enabled_with_callback(CHANGE_COLOR_PIN, GPIO_IRQ_EDGE_FALL, true, &gpio_int_callback);
+    button_add(CHANGE_COLOR_PIN, GPIO_IRQ_EDGE_FALL, BUTTON_DEBOUNCE_US, button_pressed);
 
     // GPIO INC_BRIGHTNESS pin
     printf("init INC_BRIGHTNESS_PIN\n");
-    gpio_init(INC_BRIGHTNESS_PIN);
-    gpio_pull_up(INC_BRIGHTNESS_PIN);
-    gpio_set_dir(INC_BRIGHTNESS_PIN, GPIO_IN);
-    gpio_set_irq_enabled_with_callback(INC_BRIGHTNESS_PIN, GPIO_IRQ_EDGE_FALL, true, &gpio_int_callback);
+    button_add(INC_BRIGHTNESS_PIN, GPIO_IRQ_EDGE_FALL, BUTTON_DEBOUNCE_US, button_pressed);
+
+    // Encoder, counted by PIO so it never interrupts
+    printf("init ENCODER_A_PIN\n");
+    encoder_init(&encoder, pio0, ENCODER_A_PIN);
 
     // GPIO pin 16
     printf("init RED_PIN\n");
@@ -192,10 +262,13 @@ void hardware_init(void)
     // General PWM setup
     printf("init PWM\n");
     irq_set_exclusive_handler(PWM_IRQ_WRAP, on_pwm_wrap);
+    irq_set_priority(PWM_IRQ_WRAP, PWM_IRQ_PRIORITY);
     irq_set_enabled(PWM_IRQ_WRAP, true);
 
     pwm_config config = pwm_get_default_config();
-    pwm_config_set_clkdiv(&config, 4.f);
+    // Full speed gives a 524 us period, the wrap that reads the encoder
+    // comes round in well under a millisecond
+    pwm_config_set_clkdiv(&config, 1.f);
 
     // Assume start with RED pin, init others to disabled
     pwm_init(slice_num_green, &config, false);
@@ -0,0 +1,127 @@
+/**
+ * @brief Keyframe animation player
+ *
+ * A repeating hardware alarm ticks the animation engine at a fixed frame
+ * rate. Each tick computes one frame and commits it to the PWM slices, so
+ * the PWM wrap rate only sets flicker and resolution, not animation speed.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Defines */
+#define RED_PIN         16
+#define GREEN_PIN       17
+#define BLUE_PIN        18
+
+#define CAL_RED         65536
+#define CAL_GREEN       47186   // 0.72
+#define CAL_BLUE        36045   // 0.55
+
+#define FRAME_RATE      50      // Frames per second
+#define REPORT_MS       5000
+
+/* Includes */
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/pwm.h"
+
+#include "anim.h"
+#include "pwm_group.h"
+#include "rgb_color.h"
+
+/* Globals */
+static const anim_key_t breathe_keys[] = {
+    {    0, {   0,   0,   0 }, ANIM_EASE_LINEAR },
+    { 1500, { 255,  40,   0 }, ANIM_EASE_IN_OUT },
+    { 3000, {   0,   0,   0 }, ANIM_EASE_IN_OUT },
+};
+
+static const anim_key_t cycle_keys[] = {
+    {    0, { 255,   0,   0 }, ANIM_EASE_LINEAR },
+    { 1000, {   0, 255,   0 }, ANIM_EASE_LINEAR },
+    { 2000, {   0,   0, 255 }, ANIM_EASE_LINEAR },
+    { 3000, { 255,   0,   0 }, ANIM_EASE_LINEAR },
+};
+
+static const anim_key_t flash_keys[] = {
+    {    0, { 255, 255, 255 }, ANIM_EASE_LINEAR },
+    {  100, {   0,   0,   0 }, ANIM_EASE_STEP },
+    {  300, { 255, 255, 255 }, ANIM_EASE_STEP },
+    {  400, {   0,   0,   0 }, ANIM_EASE_STEP },
+    { 1200, {   0,   0, 255 }, ANIM_EASE_OUT },
+    { 2000, {   0,   0,   0 }, ANIM_EASE_IN },
+};
+
+static const anim_effect_t effects[] = {
+    { breathe_keys, count_of(breathe_keys), 6000 },     // Two breaths
+    { cycle_keys, count_of(cycle_keys), 3000 },
+    { flash_keys, count_of(flash_keys), 2500 },
+};
+
+static const anim_seq_t show = { effects, count_of(effects), true };
+
+static anim_t anim;
+static rgb_calib_t calib;
+static pwm_group_t leds;
+static int out_red, out_green, out_blue;
+static volatile uint32_t frame_max_us;
+
+/* Prototypes */
+void hardware_init(void);
+
+/* Interrupt handlers */
+// Alarm IRQ, one frame per call
+bool frame_tick(repeating_timer_t *rt)
+{
+    uint64_t start = time_us_64();
+    rgb16_t level = rgb_calib_apply(&calib, anim_step(&anim));
+
+    pwm_group_set(&leds, out_red, level.r);
+    pwm_group_set(&leds, out_green, level.g);
+    pwm_group_set(&leds, out_blue, level.b);
+    pwm_group_commit(&leds);
+
+    uint32_t took = time_us_64() - start;
+    if (took > frame_max_us) {
+        frame_max_us = took;
+    }
+    return true;
+}
+
+/* Code */
+int main()
+{
+    repeating_timer_t timer;
+
+    stdio_init_all();
+    hardware_init();
+
+    anim_init(&anim, &show, FRAME_RATE);
+
+    // Negative period: fixed rate from the previous start, no drift from
+    // time spent in the callback
+    add_repeating_timer_us(-1000000 / FRAME_RATE, frame_tick, NULL, &timer);
+
+    while (1) {
+        sleep_ms(REPORT_MS);
+        printf("anim: %lu frames, effect %lu, worst frame %lu us, %lu pwm writes\n",
+               anim.frames, anim.effect, frame_max_us, leds.writes);
+    }
+}
+
+/* Initialization functions */
+void hardware_init(void)
+{
+    rgb_calib_init(&calib, CAL_RED, CAL_GREEN, CAL_BLUE);
+
+    pwm_config config = pwm_get_default_config();
+    pwm_config_set_clkdiv(&config, 4.f);
+    pwm_group_init(&leds, &config);
+    out_red = pwm_group_add(&leds, RED_PIN);
+    out_green = pwm_group_add(&leds, GREEN_PIN);
+    out_blue = pwm_group_add(&leds, BLUE_PIN);
+    pwm_group_commit(&leds);
+    pwm_group_start(&leds);
+}
@@ -5,45 +5,48 @@
  *
  * SPDX-License-Identifier: BSD-3-Clause
  */
+#pragma once
 
 #include "pico/stdlib.h"
 
 /* LCD Constants */
 // commands
-const int LCD_CLEARDISPLAY = 0x01;
-const int LCD_RETURNHOME = 0x02;
-const int LCD_ENTRYMODESET = 0x04;
-const int LCD_DISPLAYCONTROL = 0x08;
-const int LCD_CURSORSHIFT = 0x10;
-const int LCD_FUNCTIONSET = 0x20;
-const int LCD_SETCGRAMADDR = 0x40;
-const int LCD_SETDDRAMADDR = 0x80;
+static const int LCD_CLEARDISPLAY = 0x01;
+static const int LCD_RETURNHOME = 0x02;
+static const int LCD_ENTRYMODESET = 0x04;
+static const int LCD_DISPLAYCONTROL = 0x08;
+static const int LCD_CURSORSHIFT = 0x10;
+static const int LCD_FUNCTIONSET = 0x20;
+static const int LCD_SETCGRAMADDR = 0x40;
+static const int LCD_SETDDRAMADDR = 0x80;
 
 // flags for display entry mode
-const int LCD_ENTRYSHIFTINCREMENT = 0x01;
-const int LCD_ENTRYLEFT = 0x02;
+static const int LCD_ENTRYSHIFTINCREMENT = 0x01;
+static const int LCD_ENTRYLEFT = 0x02;
 
 // flags for display and cursor control
-const int LCD_BLINKON = 0x01;
-const int LCD_CURSORON = 0x02;
-const int LCD_DISPLAYON = 0x04;
+static const int LCD_BLINKON = 0x01;
+static const int LCD_CURSORON = 0x02;
+static const int LCD_DISPLAYON = 0x04;
 
 // flags for display and cursor shift
-const int LCD_MOVERIGHT = 0x04;
-const int LCD_DISPLAYMOVE = 0x08;
+static const int LCD_MOVELEFT = 0x00;
+static const int LCD_MOVERIGHT = 0x04;
+static const int LCD_DISPLAYMOVE = 0x08;
 
 // flags for function set
-const int LCD_5x10DOTS = 0x04;
-const int LCD_2LINE = 0x08;
-const int LCD_8BITMODE = 0x10;
+static const int LCD_5x10DOTS = 0x04;
+static const int LCD_2LINE = 0x08;
+static const int LCD_8BITMODE = 0x10;
 
 // flag for backlight control
-const int LCD_BACKLIGHT = 0x08;
+static const int LCD_BACKLIGHT = 0x08;
 
-const int LCD_ENABLE_BIT = 0x04;
+static const int LCD_RW_BIT = 0x02;
+static const int LCD_ENABLE_BIT = 0x04;
 
 // By default these LCD display drivers are on bus address 0x27
-static int lcd_addr = 0x27;
+#define LCD_I2C_ADDR    0x27
 
 // Modes for lcd_send_byte
 #define LCD_CHARACTER   1
@@ -52,10 +55,95 @@ static int lcd_addr = 0x27;
 #define MAX_LINES       2
 #define MAX_CHARS       16
 
+// Each line of DDRAM is 40 columns whatever the glass shows
+#define LCD_DDRAM_COLS  40
+
+// Show messages.txt from the pre-encoded streams built by lcd_msgc.py,
+// otherwise the text is drawn through the framebuffer
+#define LCD_CANNED_SCREENS      1
+
+/* Level meter demo, replaces the message task */
+#define LCD_DEMO_LEVEL_METER    0
+#define LCD_METER_FPS           25
+#define LCD_METER_ADC_PIN       26
+#define LCD_METER_ADC_INPUT     0
+
+/* Marquee demo, replaces the message task. Text longer than the 40
+   DDRAM columns is followed by LCD_MARQUEE_GAP blanks before it repeats. */
+#define LCD_DEMO_MARQUEE        0
+#define LCD_MARQUEE_STEP_MS     300
+#define LCD_MARQUEE_GAP         4
+
 /* Other constants */
 #define HEARTBEAT_DELAY_MS  500
+#define I2C_STATS_BEATS     10
 #define TOGGLE_DELAY_MS     1
 
+// Display backends, the lcd_* API is the same for each
+#define LCD_BACKEND_I2C         0   // PCF8574 expander on the I2C bus
+#define LCD_BACKEND_PIO         1   // Direct 4-bit bus driven by PIO and DMA
+#define LCD_BACKEND_OLED        2   // SSD1306 128x64 OLED emulating the HD44780
+#define LCD_BACKEND             LCD_BACKEND_I2C
+
+// PIO backend pins, D4-D7 then RS must be consecutive, R/W tied low
+#define LCD_PIO_DATA_PIN        6
+#define LCD_PIO_E_PIN           11
+
+// OLED backend, text line n is drawn on page FIRST_PAGE + n * LINE_PAGES
+// in 8 pixel wide cells, so 16 characters fill the 128 columns
+#define LCD_OLED_ADDR           0x3C
+#define LCD_OLED_FIRST_PAGE     2
+#define LCD_OLED_LINE_PAGES     3
+#define LCD_OLED_CELL_WIDTH     8
+
+// Batched mode encodes whole strings into one I2C transaction. Enable pulse
+// width then comes from the bus byte time (~90 us at 100 kHz), so only
+// commands need an explicit wait. Set to 0 for the original per-byte path.
+#define LCD_BATCH_WRITES        1
+#define LCD_BATCH_MAX_CHARS     40
+#define LCD_COMMAND_DELAY_US    2000
+
+// Command timing, see lcd_timing_t. The PIO backend cannot read the busy
+// flag and uses the table instead. Execution times up to the bus slack
+// have passed by the time the next transfer strobes E. On I2C that is the
+// address plus three expander bytes at the negotiated speed, the PIO
+// backend uses LCD_TIMING_BUS_SLACK_US.
+#define LCD_TIMING_DEFAULT      LCD_TIMING_TABLE
+#define LCD_TIMING_MARGIN_PCT   20
+#define LCD_TIMING_BUS_SLACK_US 45
+#define LCD_INIT_DELAY_US       4100
+#define LCD_TIMING_BENCHMARK    0       // Printed by the heartbeat once USB is up
+#define LCD_BENCH_LINES         8
+
+// Shadow framebuffer limits, and how many unchanged cells a flush will
+// rewrite to join two dirty runs instead of issuing a cursor move
+#define LCD_FB_MAX_ROWS         4
+#define LCD_FB_MAX_COLS         40
+#define LCD_FB_MERGE_GAP        4
+
+// Async service task request queue, text requests are copied into it
+#define LCD_ASYNC_QUEUE_LEN     8
+#define LCD_ASYNC_MAX_CHARS     40
+
+// Devices start at the default speed and are then negotiated up to their
+// own limit, at most 1 MHz.
+//
+// Batched characters follow each other with no gap, the next character
+// latches three expander bytes after the last one's E fall. The HD44780
+// needs 41 us plus LCD_TIMING_MARGIN_PCT, 3 x 9 bit times is 27 us at
+// 1 MHz and 67 us at 400 kHz, so the LCD stops at 400 kHz. The PCF8574
+// itself is only rated for 100 kHz, the readback check decides if this
+// one keeps up.
+#define LCD_I2C_MAX_BAUD        (400 * 1000)
+#define LCD_OLED_MAX_BAUD       (1000 * 1000)
+
+// Rise time is 0.847 RC of the pull-ups against the bus capacitance, the
+// expander backpacks carry 4.7k.
+#define I2C_BAUD_DEFAULT        (100 * 1000)
+#define I2C_PULLUP_OHMS         4700
+#define I2C_BUS_PF              50
+#define I2C_RISE_NS             (I2C_PULLUP_OHMS * I2C_BUS_PF / 1000 * 847 / 1000)
+
 #define _I2C_NUM        &i2c1_inst
 #define _I2C_SDA_PIN    2
 #define _I2C_SCL_PIN    3
\ No newline at end of file
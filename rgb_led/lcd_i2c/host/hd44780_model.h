@@ -0,0 +1,166 @@
+/**
+ * @brief Host model of an HD44780 behind a PCF8574 I2C expander
+ *
+ * The mock bus times each transaction bit by bit and hands every expander
+ * byte to the model at the moment its pins would change, the ACK of that
+ * byte. The model latches a nibble on each falling E with RS from the
+ * same byte, runs the instruction once it has both nibbles and keeps the
+ * DDRAM and address counter. A nibble that latches while the previous
+ * instruction is still executing is counted as a timing violation, using
+ * the datasheet's nominal execution times.
+ *
+ * The controller is taken to be initialised in 4-bit mode already, as
+ * lcd_init() leaves it, with increment entry mode and two lines.
+ *
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "constants.h"
+
+/* Types */
+typedef struct {
+    uint8_t ddram[2][LCD_DDRAM_COLS];
+    uint8_t ac;             // DDRAM address, line 1 starts at 0x40
+    bool cgram;             // Address counter is in CGRAM
+    uint8_t port;           // Expander outputs
+    bool have_high;
+    uint8_t high;
+
+    // Timing, in us on the mock bus clock
+    double busy_until;
+    double min_slack;       // Closest a nibble came to the busy time
+    uint32_t violations;
+
+    uint32_t data_writes;
+    uint32_t commands;
+} hd44780_model_t;
+
+typedef struct {
+    unsigned baudrate;
+    double now_us;          // Bus time, transactions are back to back
+    double idle_us;         // Sleeps between transactions
+    uint32_t xfers;
+    uint32_t bytes;         // Address bytes included
+} mock_bus_t;
+
+/* Code */
+static inline void hd44780_model_init(hd44780_model_t *m) {
+    memset(m, 0, sizeof(*m));
+    memset(m->ddram, ' ', sizeof(m->ddram));
+    m->port = LCD_BACKLIGHT;
+    m->min_slack = 1e9;
+}
+
+// Line 0 is 0x00-0x27 and line 1 0x40-0x67, each wraps into the other
+static inline void hd44780_model_advance(hd44780_model_t *m) {
+    if ((m->ac & 0x3F) + 1 < LCD_DDRAM_COLS) {
+        m->ac++;
+    } else {
+        m->ac = (m->ac & 0x40) ^ 0x40;
+    }
+}
+
+static inline void hd44780_model_execute(hd44780_model_t *m, uint8_t val, bool rs, double t) {
+    double exec_us = 37;
+
+    if (rs) {
+        m->data_writes++;
+        exec_us = 37 + 4;
+        if (!m->cgram) {
+            m->ddram[m->ac >> 6][m->ac & 0x3F] = val;
+            hd44780_model_advance(m);
+        }
+    } else {
+        m->commands++;
+
+        // The highest set bit selects the instruction
+        switch (val ? 1 << (31 - __builtin_clz(val)) : 0) {
+            case 0x80:  // LCD_SETDDRAMADDR
+                m->ac = val & 0x7F;
+                m->cgram = false;
+                break;
+            case 0x40:  // LCD_SETCGRAMADDR
+                m->cgram = true;
+                break;
+            case 0x10:  // LCD_CURSORSHIFT, display shifts leave the counter
+                if (!(val & LCD_DISPLAYMOVE) && (val & LCD_MOVERIGHT)) {
+                    hd44780_model_advance(m);
+                }
+                break;
+            case 0x02:  // LCD_RETURNHOME
+                m->ac = 0;
+                m->cgram = false;
+                exec_us = 1520;
+                break;
+            case 0x01:  // LCD_CLEARDISPLAY
+                memset(m->ddram, ' ', sizeof(m->ddram));
+                m->ac = 0;
+                m->cgram = false;
+                exec_us = 1520;
+                break;
+            default:    // Modes lcd_init() sets, the model assumes them
+                break;
+        }
+    }
+    m->busy_until = t + exec_us;
+}
+
+// Expander outputs take val at time t
+static inline void hd44780_model_port(hd44780_model_t *m, uint8_t val, double t) {
+    bool fall = (m->port & LCD_ENABLE_BIT) && !(val & LCD_ENABLE_BIT);
+
+    // Nibble and RS are what the pins held while E was high
+    uint8_t latched = m->port;
+    m->port = val;
+    if (!fall || (latched & LCD_RW_BIT)) {
+        return;
+    }
+
+    if (!m->have_high) {
+        double slack = t - m->busy_until;
+        if (slack < m->min_slack) {
+            m->min_slack = slack;
+        }
+        if (slack < 0) {
+            m->violations++;
+        }
+        m->high = latched & 0xF0;
+        m->have_high = true;
+    } else {
+        m->have_high = false;
+        hd44780_model_execute(m, m->high | latched >> 4, latched & LCD_CHARACTER, t);
+    }
+}
+
+// Text of a line as DDRAM holds it
+static inline void hd44780_model_line(const hd44780_model_t *m, int line, char *out, int cols) {
+    memcpy(out, m->ddram[line], cols);
+    out[cols] = '\0';
+}
+
+// Start and address byte, then each byte's pins change at its ACK
+static inline void mock_bus_write(mock_bus_t *bus, hd44780_model_t *m,
+                                  const uint8_t *buf, size_t len) {
+    double bit_us = 1e6 / bus->baudrate;
+
+    bus->xfers++;
+    bus->bytes += len + 1;
+    bus->now_us += (1 + 9) * bit_us;
+    for (size_t i = 0; i < len; i++) {
+        bus->now_us += 9 * bit_us;
+        hd44780_model_port(m, buf[i], bus->now_us);
+    }
+    bus->now_us += bit_us;
+}
+
+static inline void mock_bus_sleep(mock_bus_t *bus, double us) {
+    bus->now_us += us;
+    bus->idle_us += us;
+}
@@ -0,0 +1,117 @@
+/**
+ * @brief Host benchmark of lcd_string(), per-byte against batched
+ *
+ * Both ways of writing a string drive a mock I2C bus feeding an HD44780
+ * and PCF8574 model, see hd44780_model.h. The per-byte path is the
+ * original driver's lcd_send_byte() and lcd_toggle_enable(): a single
+ * byte transaction per expander write with a 1 ms sleep around each E
+ * edge. The batched path is lcd_write() over lcd_encode_bytes(), one
+ * transaction per LCD_BATCH_MAX_CHARS. The bench counts transactions,
+ * bus bytes and time, checks DDRAM holds the string afterwards and
+ * counts HD44780 execution time violations. Batched characters have no
+ * gap between them, so above LCD_I2C_MAX_BAUD they come too fast, the
+ * bench shows 1 MHz for that and only fails on speeds the LCD is allowed.
+ *
+ *     cc -O2 -I.. -Isdk_model -o lcd_encode_bench lcd_encode_bench.c ../lcd_encode.c && ./lcd_encode_bench
+ *
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include <stdio.h>
+#include <string.h>
+
+#include "constants.h"
+#include "lcd_encode.h"
+#include "hd44780_model.h"
+
+/* Globals */
+static const unsigned bench_speeds[] = { 100 * 1000, 400 * 1000, 1000 * 1000 };
+
+static const char *bench_strings[] = {
+    "lmao kiddo      ",
+    "0123456789abcdefghijklmnopqrstuvwxyz.,:;",
+};
+
+/* Code */
+// lcd_toggle_enable() and lcd_send_byte() as they were, per expander byte
+static void old_write_byte(mock_bus_t *bus, hd44780_model_t *m, uint8_t val) {
+    mock_bus_write(bus, m, &val, 1);
+}
+
+static void old_toggle_enable(mock_bus_t *bus, hd44780_model_t *m, uint8_t val) {
+    mock_bus_sleep(bus, TOGGLE_DELAY_MS * 1000);
+    old_write_byte(bus, m, val | LCD_ENABLE_BIT);
+    mock_bus_sleep(bus, TOGGLE_DELAY_MS * 1000);
+    old_write_byte(bus, m, val & ~LCD_ENABLE_BIT);
+    mock_bus_sleep(bus, TOGGLE_DELAY_MS * 1000);
+}
+
+static void old_lcd_string(mock_bus_t *bus, hd44780_model_t *m, const char *s) {
+    while (*s) {
+        uint8_t val = *s++;
+        uint8_t high = LCD_CHARACTER | (val & 0xF0) | LCD_BACKLIGHT;
+        uint8_t low = LCD_CHARACTER | ((val << 4) & 0xF0) | LCD_BACKLIGHT;
+
+        old_write_byte(bus, m, high);
+        old_toggle_enable(bus, m, high);
+        old_write_byte(bus, m, low);
+        old_toggle_enable(bus, m, low);
+    }
+}
+
+// lcd_write() with LCD_BATCH_WRITES
+static void batch_lcd_string(mock_bus_t *bus, hd44780_model_t *m, const char *s) {
+    static uint8_t buf[LCD_BATCH_MAX_CHARS * LCD_ENCODED_BYTE_LEN];
+    size_t len = strlen(s);
+
+    while (len) {
+        size_t n = MIN(len, LCD_BATCH_MAX_CHARS);
+
+        mock_bus_write(bus, m, buf, lcd_encode_bytes(buf, (const uint8_t *) s, n, LCD_CHARACTER));
+        s += n;
+        len -= n;
+    }
+}
+
+typedef void (*string_fn_t)(mock_bus_t *bus, hd44780_model_t *m, const char *s);
+
+// Returns the time taken, 0 when DDRAM does not hold the string or an
+// allowed speed broke the timing
+static double run(const char *name, string_fn_t fn, unsigned baudrate, const char *s) {
+    mock_bus_t bus = { baudrate };
+    hd44780_model_t m;
+    char line[LCD_DDRAM_COLS + 1];
+    size_t len = strlen(s);
+
+    hd44780_model_init(&m);
+    fn(&bus, &m, s);
+    hd44780_model_line(&m, 0, line, len);
+
+    int ok = strcmp(line, s) == 0 && (m.violations == 0 || baudrate > LCD_I2C_MAX_BAUD);
+    printf("  %-8s %4u xfers %5u bytes %9.0f us %7.1f us/char  %2u late, closest %6.1f us  %s\n",
+           name, bus.xfers, bus.bytes, bus.now_us, bus.now_us / len, m.violations,
+           m.min_slack, ok ? "ok" : "FAIL");
+    return ok ? bus.now_us : 0;
+}
+
+int main(void) {
+    int failed = 0;
+
+    for (size_t i = 0; i < sizeof(bench_speeds) / sizeof(bench_speeds[0]); i++) {
+        for (size_t j = 0; j < sizeof(bench_strings) / sizeof(bench_strings[0]); j++) {
+            const char *s = bench_strings[j];
+
+            printf("%u kHz, %zu chars%s\n", bench_speeds[i] / 1000, strlen(s),
+                   bench_speeds[i] > LCD_I2C_MAX_BAUD ? ", above LCD_I2C_MAX_BAUD" : "");
+            double old_us = run("per-byte", old_lcd_string, bench_speeds[i], s);
+            double batch_us = run("batched", batch_lcd_string, bench_speeds[i], s);
+            printf("  speedup %.1fx\n", batch_us ? old_us / batch_us : 0.0);
+
+            failed |= !old_us || !batch_us;
+        }
+    }
+    return failed;
+}
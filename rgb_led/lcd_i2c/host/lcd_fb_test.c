@@ -0,0 +1,222 @@
+/**
+ * @brief Host test of the LCD shadow framebuffer against an HD44780 model
+ *
+ * Runs lcd_fb.c unmodified. The driver calls it makes, lcd_set_cursor()
+ * and lcd_write(), are the batched I2C versions here: encoded with
+ * lcd_encode.c and sent over the mock bus into the HD44780 and PCF8574
+ * model from hd44780_model.h. After every flush of random edits the
+ * model's DDRAM must equal the framebuffer, and its address counter must
+ * be where the framebuffer thinks the cursor is.
+ *
+ * Then measures cells and cursor moves for a few typical redraws against
+ * what the old clear-and-rewrite redraw sends.
+ *
+ *     cc -O2 -I.. -Isdk_model -o lcd_fb_test lcd_fb_test.c ../lcd_fb.c ../lcd_encode.c && ./lcd_fb_test
+ *
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Defines */
+#define RANDOM_ROUNDS   20000
+#define BUS_BAUD        (400 * 1000)
+
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lcd.h"
+#include "lcd_encode.h"
+#include "lcd_fb.h"
+#include "lcd_glyph.h"
+#include "hd44780_model.h"
+
+/* Globals */
+static const int line_offsets[] = { 0x00, 0x40 };
+
+static mock_bus_t bus;
+static hd44780_model_t model;
+
+/* Code */
+// The driver functions lcd_fb.c calls, as lcd_i2c.c does them batched
+void lcd_set_cursor(int line, int position) {
+    uint8_t buf[LCD_ENCODED_BYTE_LEN];
+
+    lcd_encode_byte(buf, LCD_SETDDRAMADDR | (line_offsets[line & 1] + position), LCD_COMMAND);
+    mock_bus_write(&bus, &model, buf, sizeof(buf));
+}
+
+void lcd_write(const char *s, size_t len) {
+    static uint8_t buf[LCD_BATCH_MAX_CHARS * LCD_ENCODED_BYTE_LEN];
+
+    while (len) {
+        size_t n = MIN(len, LCD_BATCH_MAX_CHARS);
+
+        mock_bus_write(&bus, &model, buf,
+                       lcd_encode_bytes(buf, (const uint8_t *) s, n, LCD_CHARACTER));
+        s += n;
+        len -= n;
+    }
+}
+
+bool lcd_glyph_upload_pending(void) {
+    return false;
+}
+
+static void reset(lcd_fb_t *fb, int rows, int cols) {
+    bus = (mock_bus_t) { BUS_BAUD };
+    hd44780_model_init(&model);
+    lcd_fb_init(fb, rows, cols);
+}
+
+// DDRAM matches the framebuffer, and the address counter the cursor
+static int check(const lcd_fb_t *fb) {
+    for (int row = 0; row < fb->rows; row++) {
+        if (memcmp(model.ddram[row], fb->draw[row], fb->cols) != 0
+            || memcmp(fb->shown[row], fb->draw[row], fb->cols) != 0) {
+            printf("row %d differs\n", row);
+            return 0;
+        }
+    }
+    if (fb->cursor_row >= 0 && fb->cursor_col < LCD_DDRAM_COLS
+        && model.ac != line_offsets[fb->cursor_row] + fb->cursor_col) {
+        printf("address counter 0x%02x, framebuffer cursor %d,%d\n", model.ac,
+               fb->cursor_row, fb->cursor_col);
+        return 0;
+    }
+    return model.violations == 0;
+}
+
+static void random_edit(lcd_fb_t *fb) {
+    char text[LCD_FB_MAX_COLS + 1];
+    int row = rand() % fb->rows;
+    int col = rand() % fb->cols;
+
+    switch (rand() % 8) {
+        case 0:
+            lcd_fb_clear(fb);
+            break;
+        case 1:
+        case 2: {
+            int len = rand() % (fb->cols + 1);
+            for (int i = 0; i < len; i++) {
+                text[i] = ' ' + rand() % 95;
+            }
+            text[len] = '\0';
+            lcd_fb_print(fb, row, col, text);
+            break;
+        }
+        default:
+            lcd_fb_put(fb, row, col, ' ' + rand() % 95);
+            break;
+    }
+}
+
+static int random_test(int rows, int cols) {
+    static lcd_fb_t fb;
+
+    reset(&fb, rows, cols);
+    for (int round = 0; round < RANDOM_ROUNDS; round++) {
+        for (int edits = rand() % 6; edits >= 0; edits--) {
+            random_edit(&fb);
+        }
+        if (round % 997 == 0) {
+            lcd_fb_invalidate(&fb);
+        }
+        lcd_fb_flush(&fb);
+        if (!check(&fb)) {
+            printf("%dx%d: failed after %d rounds\n", rows, cols, round);
+            return 0;
+        }
+    }
+    printf("%dx%d: %d random rounds ok, %u cells, %u cursor moves\n", rows, cols,
+           RANDOM_ROUNDS, fb.cells_sent, fb.cursor_moves);
+    return 1;
+}
+
+// What the old redraw sent per frame: a clear, then each line from its
+// start. Every cell goes out and the clear takes 1.52 ms.
+static void redraw_cost(const char *name, const lcd_fb_t *fb, uint32_t cells, uint32_t moves,
+                        double us, int frames, double *ratio) {
+    uint32_t old_cells = fb->rows * fb->cols;
+    uint32_t old_moves = fb->rows;
+    double old_bytes = 1 + (1 + old_moves + old_cells) * LCD_ENCODED_BYTE_LEN;
+    double old_us = old_bytes * 9 * 1e6 / BUS_BAUD + 1520;
+
+    *ratio = (double) (old_cells + old_moves + 1) * frames / (cells + moves);
+    printf("  %-18s %6.1f cells %5.2f moves %7.0f us per frame, old %2u cells %u moves "
+           "%5.0f us, %5.1fx fewer writes\n", name, (double) cells / frames,
+           (double) moves / frames, us / frames, old_cells, old_moves + 1, old_us, *ratio);
+}
+
+typedef void (*frame_fn_t)(lcd_fb_t *fb, int frame);
+
+static void frame_counter(lcd_fb_t *fb, int frame) {
+    char text[LCD_FB_MAX_COLS + 1];
+
+    snprintf(text, sizeof(text), "frame %5d", frame);
+    lcd_fb_print(fb, 1, 0, text);
+}
+
+static void frame_messages(lcd_fb_t *fb, int frame) {
+    static const char *screens[][2] = {
+        { "   lmao kiddo   ", "  try harder!   " },
+        { "  hello there   ", "general kenobi  " },
+    };
+
+    lcd_fb_print(fb, 0, 0, screens[frame & 1][0]);
+    lcd_fb_print(fb, 1, 0, screens[frame & 1][1]);
+}
+
+static void frame_sparse(lcd_fb_t *fb, int frame) {
+    for (int i = 0; i < 3; i++) {
+        lcd_fb_put(fb, rand() % fb->rows, rand() % fb->cols, 'a' + rand() % 26);
+    }
+}
+
+static int workload(const char *name, frame_fn_t fn, double *ratio) {
+    static lcd_fb_t fb;
+    const int frames = 1000;
+
+    reset(&fb, MAX_LINES, MAX_CHARS);
+    lcd_fb_print(&fb, 0, 0, "Level  100/4095");
+    fn(&fb, 0);
+    lcd_fb_flush(&fb);
+
+    uint32_t cells = fb.cells_sent, moves = fb.cursor_moves;
+    double start_us = bus.now_us;
+    int ok = 1;
+
+    for (int frame = 1; frame <= frames; frame++) {
+        fn(&fb, frame);
+        lcd_fb_flush(&fb);
+        ok &= check(&fb);
+    }
+    redraw_cost(name, &fb, fb.cells_sent - cells, fb.cursor_moves - moves,
+                bus.now_us - start_us, frames, ratio);
+    return ok;
+}
+
+int main(void) {
+    double counter, messages, sparse;
+    int ok = 1;
+
+    srand(1);
+    ok &= random_test(2, 16);
+    ok &= random_test(2, 20);
+    ok &= random_test(2, 40);
+
+    printf("\n2x16 redraws at %u kHz:\n", BUS_BAUD / 1000);
+    ok &= workload("counter", frame_counter, &counter);
+    ok &= workload("alternate screens", frame_messages, &messages);
+    ok &= workload("3 random cells", frame_sparse, &sparse);
+
+    // A changing counter is the case the framebuffer is for
+    if (counter < 10) {
+        printf("counter redraw is not an order of magnitude cheaper\n");
+        ok = 0;
+    }
+    return ok ? 0 : 1;
+}
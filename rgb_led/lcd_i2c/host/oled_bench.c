@@ -0,0 +1,138 @@
+/**
+ * @brief Host benchmark for the OLED framebuffer against an SSD1306 model
+ *
+ * Runs oled_fb.c unmodified, feeds its transactions to a model of the
+ * controller's GDDRAM and address window, checks the model ends up showing
+ * the framebuffer and reports bytes per frame and refresh rate per speed.
+ *
+ *     cc -O2 -I.. -o oled_bench oled_bench.c ../oled_fb.c && ./oled_bench
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include <stdio.h>
+#include <string.h>
+
+#include "oled_fb.h"
+
+/* Types */
+typedef struct {
+    uint8_t gddram[OLED_PAGES][OLED_WIDTH];
+    int col_lo, col_hi, page_lo, page_hi;
+    int col, page;
+
+    // Bus traffic since the last frame, address byte included
+    uint32_t xfers;
+    uint32_t bytes;
+} ssd1306_model_t;
+
+/* Globals */
+static const unsigned bench_speeds[] = { 100 * 1000, 400 * 1000, 1000 * 1000 };
+
+/* Code */
+// Only the commands oled_fb.c sends are modelled: column and page address
+static void model_send(void *ctx, const uint8_t *buf, size_t len) {
+    ssd1306_model_t *m = ctx;
+
+    m->xfers++;
+    m->bytes += len + 1;
+
+    if (buf[0] == OLED_CTRL_CMD) {
+        for (size_t i = 1; i < len; i++) {
+            if (buf[i] == 0x21 && i + 2 < len) {
+                m->col_lo = m->col = buf[i + 1];
+                m->col_hi = buf[i + 2];
+                i += 2;
+            } else if (buf[i] == 0x22 && i + 2 < len) {
+                m->page_lo = m->page = buf[i + 1];
+                m->page_hi = buf[i + 2];
+                i += 2;
+            }
+        }
+        return;
+    }
+
+    for (size_t i = 1; i < len; i++) {
+        m->gddram[m->page][m->col] = buf[i];
+        if (++m->col > m->col_hi) {
+            m->col = m->col_lo;
+            if (++m->page > m->page_hi) {
+                m->page = m->page_lo;
+            }
+        }
+    }
+}
+
+// 9 bits per byte plus start and stop on each transaction
+static double frame_us(const ssd1306_model_t *m, unsigned baudrate) {
+    return (m->bytes * 9.0 + m->xfers * 2.0) * 1e6 / baudrate;
+}
+
+static int frame(const char *name, oled_fb_t *fb, ssd1306_model_t *m) {
+    m->xfers = 0;
+    m->bytes = 0;
+    oled_fb_flush(fb, model_send, m);
+
+    int ok = memcmp(m->gddram, fb->pages, sizeof(m->gddram)) == 0;
+
+    printf("%-22s %5u bytes %3u xfers", name, m->bytes, m->xfers);
+    for (size_t i = 0; i < sizeof(bench_speeds) / sizeof(bench_speeds[0]); i++) {
+        double us = frame_us(m, bench_speeds[i]);
+
+        printf("  %4u kHz %7.0f fps", bench_speeds[i] / 1000, us ? 1e6 / us : 0.0);
+    }
+    printf("  %s\n", ok ? "ok" : "MISMATCH");
+    return ok;
+}
+
+static void print_page(const ssd1306_model_t *m, int page) {
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < OLED_WIDTH; x++) {
+            putchar((m->gddram[page][x] >> y) & 1 ? '#' : '.');
+        }
+        putchar('\n');
+    }
+}
+
+int main(void) {
+    static oled_fb_t fb;
+    static ssd1306_model_t m;
+    char text[32];
+    int ok = 1;
+
+    oled_fb_init(&fb);
+    memset(m.gddram, 0xA5, sizeof(m.gddram));
+
+    ok &= frame("first flush", &fb, &m);
+    oled_fb_fill(&fb, 0x55);
+    ok &= frame("full screen 0x55", &fb, &m);
+    oled_fb_fill(&fb, 0xAA);
+    ok &= frame("full screen 0xAA", &fb, &m);
+    ok &= frame("unchanged", &fb, &m);
+    oled_fb_fill(&fb, 0x00);
+    ok &= frame("clear", &fb, &m);
+
+    // Two text lines like task_print_msg(), then one counter per frame
+    oled_fb_text(&fb, 2, 34, "lmao kiddo");
+    oled_fb_text(&fb, 5, 34, "try harder");
+    ok &= frame("two text lines", &fb, &m);
+    for (int i = 0; i < 3; i++) {
+        snprintf(text, sizeof(text), "frame %4d", 997 + i);
+        oled_fb_text(&fb, 7, 0, text);
+        snprintf(text, sizeof(text), "counter %d", 997 + i);
+        ok &= frame(text, &fb, &m);
+    }
+
+    for (int x = 0; x < OLED_WIDTH; x += 9) {
+        oled_fb_pixel(&fb, x, 8 + x % 16, 1);
+    }
+    ok &= frame("scattered pixels", &fb, &m);
+
+    printf("\n");
+    print_page(&m, 2);
+    printf("\ntotal %u windows, %u xfers, %u bytes\n", fb.windows, fb.xfers, fb.bytes);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,430 @@
+/**
+ * @brief Host PIO simulator for the 4-bit HD44780 program
+ *
+ * Assembles lcd_4bit.pio from source, for the few instructions it uses:
+ * out, nop, set and jmp, with side-set, delays and autopull stalls. It
+ * then runs the state machine cycle by cycle the way lcd_4bit_program_init()
+ * sets it up, at the fractional clkdiv it works out from a 125 MHz clk_sys.
+ * A feeder plays the DMA, packing bytes the way lcd_pio_write() does, and
+ * starves the FIFO now and then so stalls are covered.
+ *
+ * The pin trace is checked against the HD44780U write timing at 2.7-4.5 V:
+ * E pulse width, E cycle time, RS setup and hold, data setup and hold, and
+ * the gap between instructions against the execution time with
+ * LCD_TIMING_MARGIN_PCT. Nibbles are latched on each E fall and must give
+ * back the bytes sent.
+ *
+ *     cc -O2 -I.. -Isdk_model -o pio_sim pio_sim.c && ./pio_sim ../lcd_4bit.pio
+ *
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Defines */
+#define CLK_SYS_HZ      125000000
+#define PIO_HZ          4000000     // lcd_4bit_program_init()
+#define FIFO_DEPTH      8           // TX joined
+#define NUM_BYTES       2000
+#define MAX_CYCLES      (NUM_BYTES * 400)
+
+// HD44780U datasheet, bus write timing at VCC 2.7-4.5 V, in ns
+#define T_CYCE_NS       1000
+#define PW_EH_NS        450
+#define T_AS_NS         60
+#define T_AH_NS         20
+#define T_DSW_NS        195
+#define T_H_NS          10
+
+/* Includes */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "constants.h"
+
+/* Types */
+typedef enum { OP_OUT, OP_NOP, OP_SET, OP_JMP } op_t;
+typedef enum { DST_PINS, DST_NULL, DST_X, DST_Y } dst_t;
+typedef enum { JMP_ALWAYS, JMP_X_DEC, JMP_Y_DEC, JMP_NOT_X, JMP_NOT_Y } cond_t;
+
+typedef struct {
+    op_t op;
+    dst_t dst;
+    cond_t cond;
+    int arg;                // Bit count, set value or jump target
+    char target[32];
+    int side;
+    int delay;
+} insn_t;
+
+typedef struct {
+    insn_t code[32];
+    int len;
+    int wrap_target;
+    int wrap;
+    int side_bits;
+} program_t;
+
+typedef struct {
+    uint8_t pins;           // D4-D7 in bits 0-3, RS in bit 4
+    bool e;
+} pins_t;
+
+/* Globals */
+static uint16_t fifo[FIFO_DEPTH];
+static int fifo_len;
+
+static uint8_t sent[NUM_BYTES];
+static uint8_t latched[NUM_BYTES];
+static int num_latched;
+
+/* Code */
+static void fail(const char *what, int line) {
+    fprintf(stderr, "line %d: %s\n", line, what);
+    exit(2);
+}
+
+static char *trim(char *s) {
+    while (isspace((unsigned char) *s)) {
+        s++;
+    }
+    char *end = s + strlen(s);
+    while (end > s && isspace((unsigned char) end[-1])) {
+        *--end = '\0';
+    }
+    return s;
+}
+
+static dst_t parse_dst(const char *s, int line) {
+    if (!strcmp(s, "pins")) return DST_PINS;
+    if (!strcmp(s, "null")) return DST_NULL;
+    if (!strcmp(s, "x")) return DST_X;
+    if (!strcmp(s, "y")) return DST_Y;
+    fail("unsupported destination", line);
+    return DST_NULL;
+}
+
+// Only the program's own body, the c-sdk block is skipped
+static void assemble(program_t *p, const char *path) {
+    char buf[256];
+    char labels[32][32];
+    int label_pc[32], num_labels = 0;
+    bool in_sdk = false;
+    int line = 0;
+    FILE *f = fopen(path, "r");
+
+    if (!f) {
+        perror(path);
+        exit(2);
+    }
+    memset(p, 0, sizeof(*p));
+    p->wrap = -1;
+
+    while (fgets(buf, sizeof(buf), f)) {
+        line++;
+        char *semi = strchr(buf, ';');
+        if (semi) {
+            *semi = '\0';
+        }
+        char *s = trim(buf);
+
+        if (in_sdk) {
+            in_sdk = strncmp(s, "%}", 2) != 0;
+            continue;
+        }
+        if (*s == '\0' || !strncmp(s, ".program", 8)) {
+            continue;
+        }
+        if (*s == '%') {
+            in_sdk = true;
+            continue;
+        }
+        if (!strncmp(s, ".side_set", 9)) {
+            p->side_bits = atoi(s + 9);
+            if (strstr(s, "opt")) {
+                fail("optional side-set is not modelled", line);
+            }
+            continue;
+        }
+        if (!strcmp(s, ".wrap_target")) {
+            p->wrap_target = p->len;
+            continue;
+        }
+        if (!strcmp(s, ".wrap")) {
+            p->wrap = p->len - 1;
+            continue;
+        }
+        if (*s == '.') {
+            fail("unsupported directive", line);
+        }
+
+        char *colon = strchr(s, ':');
+        if (colon) {
+            *colon = '\0';
+            snprintf(labels[num_labels], sizeof(labels[0]), "%s", trim(s));
+            label_pc[num_labels++] = p->len;
+            s = trim(colon + 1);
+            if (*s == '\0') {
+                continue;
+            }
+        }
+
+        insn_t *in = &p->code[p->len++];
+        char *delay = strchr(s, '[');
+        if (delay) {
+            in->delay = atoi(delay + 1);
+            *delay = '\0';
+        }
+        char *side = strstr(s, " side ");
+        if (side) {
+            in->side = atoi(side + 6);
+            *side = '\0';
+        } else if (p->side_bits) {
+            fail("side-set missing", line);
+        }
+        if (in->delay > (1 << (5 - p->side_bits)) - 1) {
+            fail("delay does not fit beside the side-set", line);
+        }
+
+        char op[16] = "", a[32] = "", b[32] = "";
+        sscanf(s, "%15s %31[^,], %31s", op, a, b);
+        if (!strcmp(op, "out")) {
+            in->op = OP_OUT;
+            in->dst = parse_dst(trim(a), line);
+            in->arg = atoi(b);
+        } else if (!strcmp(op, "nop")) {
+            in->op = OP_NOP;
+        } else if (!strcmp(op, "set")) {
+            in->op = OP_SET;
+            in->dst = parse_dst(trim(a), line);
+            in->arg = atoi(b);
+        } else if (!strcmp(op, "jmp")) {
+            char c[16] = "", t[32] = "";
+            in->op = OP_JMP;
+            if (sscanf(s, "jmp %15s %31s", c, t) == 2) {
+                in->cond = !strcmp(c, "x--") ? JMP_X_DEC : !strcmp(c, "y--") ? JMP_Y_DEC
+                         : !strcmp(c, "!x") ? JMP_NOT_X : !strcmp(c, "!y") ? JMP_NOT_Y : -1;
+                if ((int) in->cond < 0) {
+                    fail("unsupported jump condition", line);
+                }
+                snprintf(in->target, sizeof(in->target), "%s", t);
+            } else {
+                in->cond = JMP_ALWAYS;
+                snprintf(in->target, sizeof(in->target), "%s", trim(s + 3));
+            }
+        } else {
+            fail("unsupported instruction", line);
+        }
+    }
+    fclose(f);
+
+    for (int i = 0; i < p->len; i++) {
+        if (p->code[i].op != OP_JMP) {
+            continue;
+        }
+        p->code[i].arg = -1;
+        for (int l = 0; l < num_labels; l++) {
+            if (!strcmp(labels[l], p->code[i].target)) {
+                p->code[i].arg = label_pc[l];
+            }
+        }
+        if (p->code[i].arg < 0) {
+            fail("unknown label", 0);
+        }
+    }
+    if (p->wrap < 0) {
+        p->wrap = p->len - 1;
+    }
+}
+
+// lcd_pio_write() packing, one HD44780 byte per FIFO entry
+static uint16_t pack(uint8_t val, int mode) {
+    uint8_t rs = mode ? 0x10 : 0x00;
+
+    return (rs | (val >> 4)) | ((rs | (val & 0x0F)) << 8);
+}
+
+// The feeder keeps the FIFO full like the DMA, except during starve
+static void feed(int *next, uint64_t cycle) {
+    bool starve = (cycle / 20000) % 5 == 4;
+
+    while (!starve && fifo_len < FIFO_DEPTH && *next < NUM_BYTES) {
+        fifo[fifo_len++] = pack(sent[*next], *next % 3 ? LCD_CHARACTER : LCD_COMMAND);
+        (*next)++;
+    }
+}
+
+static int check(const char *what, double got_ns, double min_ns, int *failures) {
+    if (got_ns < min_ns) {
+        if ((*failures)++ < 10) {
+            printf("  %s %.0f ns, needs %.0f ns\n", what, got_ns, min_ns);
+        }
+        return 0;
+    }
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    program_t p;
+    pins_t pins = { 0, false };
+    uint32_t osr = 0, x = 0, y = 0;
+    int osr_count = 32;     // Empty, the first out autopulls
+    int pc, next = 0, delay = 0, stalls = 0;
+    int failures = 0;
+    double div = (double) CLK_SYS_HZ / PIO_HZ;
+
+    assemble(&p, argc > 1 ? argv[1] : "../lcd_4bit.pio");
+    pc = p.wrap_target;
+    printf("%d instructions, wrap %d..%d, clkdiv %.4f\n", p.len, p.wrap_target, p.wrap,
+           (double) (int) (div * 256) / 256);
+
+    srand(1);
+    for (int i = 0; i < NUM_BYTES; i++) {
+        sent[i] = rand();
+    }
+
+    // Edge times in ns, and the stats the checks are made from
+    double last_data_ns = 0, last_rs_ns = 0, rise_ns = -1e9, prev_rise_ns = -1e9;
+    double fall_ns = -1e9, instr_end_ns = -1e12;
+    double min_pw = 1e9, min_cyc = 1e9, min_as = 1e9, min_dsw = 1e9, min_h = 1e9;
+    double min_ah = 1e9, min_gap = 1e9;
+    bool second = false, fell = false;
+    double exec_ns = (37 + 4) * (100 + LCD_TIMING_MARGIN_PCT) / 100 * 1000.0;
+
+    for (uint64_t cycle = 0; cycle < MAX_CYCLES && num_latched < NUM_BYTES; cycle++) {
+        // Fractional divider, cycle n starts on sys clock floor(n * div)
+        double now_ns = (double) (uint64_t) (cycle * div) * 1e9 / CLK_SYS_HZ;
+        pins_t before = pins;
+
+        feed(&next, cycle);
+
+        if (delay) {
+            delay--;
+            continue;
+        }
+
+        const insn_t *in = &p.code[pc];
+        bool stalled = false;
+        int jump = -1;
+
+        // Side-set is asserted as the instruction starts, stalled or not
+        pins.e = in->side & 1;
+
+        switch (in->op) {
+            case OP_OUT:
+                if (osr_count >= 16) {
+                    if (fifo_len == 0) {
+                        stalled = true;
+                        break;
+                    }
+                    osr = fifo[0];
+                    memmove(fifo, fifo + 1, --fifo_len * sizeof(fifo[0]));
+                    osr_count = 0;
+                }
+                uint32_t bits = osr & ((1u << in->arg) - 1);
+                osr >>= in->arg;
+                osr_count += in->arg;
+                if (in->dst == DST_PINS) {
+                    pins.pins = bits & 0x1F;
+                } else if (in->dst == DST_X) {
+                    x = bits;
+                } else if (in->dst == DST_Y) {
+                    y = bits;
+                }
+                break;
+            case OP_NOP:
+                break;
+            case OP_SET:
+                if (in->dst == DST_X) {
+                    x = in->arg;
+                } else if (in->dst == DST_Y) {
+                    y = in->arg;
+                } else if (in->dst == DST_PINS) {
+                    fail("set pins is not modelled", 0);
+                }
+                break;
+            case OP_JMP:
+                switch (in->cond) {
+                    case JMP_ALWAYS: jump = in->arg; break;
+                    case JMP_X_DEC: jump = x-- ? in->arg : -1; break;
+                    case JMP_Y_DEC: jump = y-- ? in->arg : -1; break;
+                    case JMP_NOT_X: jump = !x ? in->arg : -1; break;
+                    case JMP_NOT_Y: jump = !y ? in->arg : -1; break;
+                }
+                break;
+        }
+
+        // Edges
+        if ((pins.pins & 0x0F) != (before.pins & 0x0F)) {
+            last_data_ns = now_ns;
+            if (fell) {
+                min_h = MIN(min_h, now_ns - fall_ns);
+            }
+        }
+        if ((pins.pins ^ before.pins) & 0x10) {
+            last_rs_ns = now_ns;
+            if (fell) {
+                min_ah = MIN(min_ah, now_ns - fall_ns);
+            }
+        }
+        if (pins.e && !before.e) {
+            prev_rise_ns = rise_ns;
+            rise_ns = now_ns;
+            min_cyc = MIN(min_cyc, rise_ns - prev_rise_ns);
+            min_as = MIN(min_as, rise_ns - last_rs_ns);
+            fell = false;
+        }
+        if (!pins.e && before.e) {
+            fall_ns = now_ns;
+            fell = true;
+            min_pw = MIN(min_pw, fall_ns - rise_ns);
+            min_dsw = MIN(min_dsw, fall_ns - last_data_ns);
+
+            // Nibbles latch on the fall, the first of each byte must wait
+            // for the previous instruction
+            uint8_t nibble = before.pins & 0x0F;
+            if (!second) {
+                min_gap = MIN(min_gap, fall_ns - instr_end_ns);
+                latched[num_latched] = nibble << 4;
+            } else {
+                latched[num_latched++] |= nibble;
+                instr_end_ns = fall_ns;
+            }
+            second = !second;
+        }
+
+        if (stalled) {
+            stalls++;
+            continue;
+        }
+        delay = in->delay;
+        if (jump >= 0) {
+            pc = jump;
+        } else {
+            pc = pc == p.wrap ? p.wrap_target : pc + 1;
+        }
+    }
+
+    int ok = 1;
+    printf("%d bytes latched, %d stalled cycles\n", num_latched, stalls);
+    ok &= num_latched == NUM_BYTES && memcmp(latched, sent, NUM_BYTES) == 0;
+    if (!ok) {
+        printf("  latched bytes differ from the bytes sent\n");
+    }
+    ok &= check("E pulse width", min_pw, PW_EH_NS, &failures);
+    ok &= check("E cycle time", min_cyc, T_CYCE_NS, &failures);
+    ok &= check("RS setup", min_as, T_AS_NS, &failures);
+    ok &= check("RS hold", min_ah, T_AH_NS, &failures);
+    ok &= check("data setup", min_dsw, T_DSW_NS, &failures);
+    ok &= check("data hold", min_h, T_H_NS, &failures);
+    ok &= check("instruction gap", min_gap, exec_ns, &failures);
+
+    printf("E high %.0f ns (%d), E cycle %.0f ns (%d), RS setup %.0f ns (%d), RS hold %.0f ns (%d)\n",
+           min_pw, PW_EH_NS, min_cyc, T_CYCE_NS, min_as, T_AS_NS, min_ah, T_AH_NS);
+    printf("data setup %.0f ns (%d), data hold %.0f ns (%d), instruction gap %.1f us (%.1f)\n",
+           min_dsw, T_DSW_NS, min_h, T_H_NS, min_gap / 1000, exec_ns / 1000);
+    printf("%s\n", ok ? "ok" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,16 @@
+/**
+ * @brief Host stand-in for the FreeRTOS headers
+ *
+ * Only the types i2c_bus.h declares with, task.h and queue.h include this.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdint.h>
+
+typedef unsigned long UBaseType_t;
+typedef void *TaskHandle_t;
+typedef void *QueueHandle_t;
@@ -0,0 +1,14 @@
+/**
+ * @brief Host stand-in for the SDK's hardware/i2c.h
+ *
+ * Only the types i2c_bus.h declares with.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include "pico/stdlib.h"
+
+typedef struct i2c_inst i2c_inst_t;
@@ -0,0 +1,19 @@
+/**
+ * @brief Host stand-in for the SDK's pico/stdlib.h
+ *
+ * Only the types and macros the LCD headers and lcd_fb.c use.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef unsigned int uint;
+
+#define MIN(a, b)   ((b) < (a) ? (b) : (a))
+#define MAX(a, b)   ((a) < (b) ? (b) : (a))
@@ -0,0 +1,10 @@
+/**
+ * @brief Host stand-in for the FreeRTOS task.h
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include "FreeRTOS.h"
@@ -0,0 +1,451 @@
+/**
+ * @brief Shared I2C bus manager
+ *
+ * Each bus (i2c0 or i2c1) gets one task that owns the controller. Devices
+ * on it submit transfers into one queue per device priority and the task
+ * always takes the highest priority work first. Transfers are encoded into
+ * IC_DATA_CMD entries and fed to the TX FIFO by DMA, with reads drained by
+ * a second channel. While one transfer is on the bus the next one is
+ * encoded into the other buffer, so it starts as soon as STOP_DET fires.
+ *
+ * Each device runs at its own speed. i2c_dev_negotiate() picks the fastest
+ * one that passes a check, and repeated errors drop it a step later on.
+ * The SCL counts for every speed are worked out once from the bus rise
+ * time, and switched while the controller is disabled to set the target.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/gpio.h"
+#include "hardware/irq.h"
+
+#include "i2c_bus.h"
+
+/* Globals */
+static i2c_bus_t *i2c_buses[2];
+
+// Speeds and the spec's minimum SCL low and high times for each, in ns
+static const uint i2c_bus_speeds[I2C_BUS_SPEEDS] = { 1000 * 1000, 400 * 1000, 100 * 1000 };
+static const uint i2c_bus_tlow_ns[I2C_BUS_SPEEDS] = { 500, 1300, 4700 };
+static const uint i2c_bus_thigh_ns[I2C_BUS_SPEEDS] = { 260, 600, 4000 };
+
+/* Prototypes */
+static void i2c_bus_task(void* arg);
+static void i2c_bus_irq0(void);
+static void i2c_bus_irq1(void);
+
+/* Code */
+static uint i2c_bus_cycles(uint32_t clk, uint ns) {
+    return ((uint64_t) clk * ns + 999999999) / 1000000000;
+}
+
+// The controller only counts SCL high once it sees the line high, so the
+// rise time through the pull-ups comes out of the period first. What is
+// left over the spec minimums is split between low and high.
+static void i2c_bus_timing(i2c_timing_t *t, int speed, uint rise_ns) {
+    uint32_t clk = clock_get_hz(clk_sys);
+    uint baudrate = i2c_bus_speeds[speed];
+    uint period = (clk + baudrate / 2) / baudrate;
+    uint rise = i2c_bus_cycles(clk, rise_ns);
+    uint tlow = i2c_bus_cycles(clk, i2c_bus_tlow_ns[speed]);
+    uint thigh = MAX(i2c_bus_cycles(clk, i2c_bus_thigh_ns[speed]), 8);
+
+    t->baudrate = 0;
+    if (period < rise + tlow + thigh) {
+        return;
+    }
+    t->lcnt = tlow + (period - rise - tlow - thigh) / 2;
+    t->hcnt = period - rise - t->lcnt;
+    t->spklen = t->lcnt < 16 ? 1 : t->lcnt / 16;
+
+    // Same data hold times the SDK uses
+    t->sda_hold = baudrate < 1000 * 1000 ? clk * 3 / 10000000 + 1 : clk * 3 / 25000000 + 1;
+    if (t->sda_hold + 2 > t->lcnt) {
+        return;
+    }
+    t->baudrate = baudrate;
+}
+
+// Controller must be disabled
+static void i2c_bus_apply_timing(i2c_bus_t *bus, int speed) {
+    const i2c_timing_t *t = &bus->timings[speed];
+    i2c_hw_t *hw = i2c_get_hw(bus->i2c);
+
+    hw->fs_scl_hcnt = t->hcnt;
+    hw->fs_scl_lcnt = t->lcnt;
+    hw->fs_spklen = t->spklen;
+    hw_write_masked(&hw->sda_hold, t->sda_hold << I2C_IC_SDA_HOLD_IC_SDA_TX_HOLD_LSB,
+                    I2C_IC_SDA_HOLD_IC_SDA_TX_HOLD_BITS);
+    bus->applied = speed;
+}
+
+// baudrate is where devices start before negotiation, rise_ns is the
+// 10-90% rise time of SCL and SDA with the bus's pull-ups
+void i2c_bus_init(i2c_bus_t *bus, i2c_inst_t *i2c, uint baudrate, uint sda, uint scl,
+                  uint rise_ns, UBaseType_t task_priority) {
+    uint index = i2c_hw_index(i2c);
+
+    bus->i2c = i2c;
+    bus->devs = NULL;
+    i2c_buses[index] = bus;
+
+    i2c_init(i2c, baudrate);
+
+    bus->default_speed = I2C_BUS_SPEEDS - 1;
+    for (int speed = I2C_BUS_SPEEDS - 1; speed >= 0; speed--) {
+        i2c_bus_timing(&bus->timings[speed], speed, rise_ns);
+        if (bus->timings[speed].baudrate && bus->timings[speed].baudrate <= baudrate) {
+            bus->default_speed = speed;
+        }
+    }
+    i2c_get_hw(i2c)->enable = 0;
+    i2c_bus_apply_timing(bus, bus->default_speed);
+    i2c_get_hw(i2c)->enable = 1;
+    gpio_set_function(sda, GPIO_FUNC_I2C);
+    gpio_set_function(scl, GPIO_FUNC_I2C);
+    gpio_pull_up(sda);
+    gpio_pull_up(scl);
+
+    bus->dma_tx = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(bus->dma_tx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, i2c_get_dreq(i2c, true));
+    dma_channel_configure(bus->dma_tx, &c, &i2c_get_hw(i2c)->data_cmd, NULL, 0, false);
+
+    bus->dma_rx = dma_claim_unused_channel(true);
+    c = dma_channel_get_default_config(bus->dma_rx);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, i2c_get_dreq(i2c, false));
+    dma_channel_configure(bus->dma_rx, &c, NULL, &i2c_get_hw(i2c)->data_cmd, 0, false);
+
+    for (int p = 0; p < I2C_BUS_PRIORITIES; p++) {
+        bus->queues[p] = xQueueCreate(I2C_BUS_QUEUE_LEN, sizeof(i2c_xfer_t *));
+    }
+
+    // Interrupts are only unmasked while a DMA transfer is running
+    i2c_get_hw(i2c)->intr_mask = 0;
+    irq_set_exclusive_handler(I2C0_IRQ + index, index ? i2c_bus_irq1 : i2c_bus_irq0);
+    irq_set_enabled(I2C0_IRQ + index, true);
+
+    bus->start_us = time_us_64();
+    xTaskCreate(i2c_bus_task, index ? "I2C1_Task" : "I2C0_Task", 256, bus, task_priority,
+                &bus->task);
+}
+
+void i2c_dev_init(i2c_dev_t *dev, i2c_bus_t *bus, uint8_t addr, uint8_t priority) {
+    dev->bus = bus;
+    dev->addr = addr;
+    dev->priority = MIN(priority, I2C_BUS_PRIORITIES - 1);
+    dev->speed = bus->default_speed;
+    dev->error_run = 0;
+    dev->xfers = 0;
+    dev->bytes = 0;
+    dev->errors = 0;
+    dev->fallbacks = 0;
+    dev->busy_us = 0;
+
+    dev->next = bus->devs;
+    bus->devs = dev;
+}
+
+// Non-blocking, returns false when the device's priority queue is full
+bool i2c_bus_submit(i2c_xfer_t *xfer) {
+    i2c_bus_t *bus = xfer->dev->bus;
+
+    if (xfer->tx_len + xfer->rx_len > I2C_BUS_MAX_XFER || xfer->tx_len + xfer->rx_len == 0) {
+        return false;
+    }
+    if (xQueueSend(bus->queues[xfer->dev->priority], &xfer, 0) != pdTRUE) {
+        return false;
+    }
+    xTaskNotifyGiveIndexed(bus->task, I2C_BUS_SUBMIT_INDEX);
+    return true;
+}
+
+static void i2c_dev_account(i2c_dev_t *dev, size_t bytes, uint64_t us, int result) {
+    dev->xfers++;
+    dev->bytes += bytes;
+    dev->busy_us += us;
+    if (result == PICO_OK) {
+        dev->error_run = 0;
+        return;
+    }
+
+    dev->errors++;
+    if (++dev->error_run < I2C_BUS_FALLBACK_ERRORS) {
+        return;
+    }
+    dev->error_run = 0;
+    for (int speed = dev->speed + 1; speed < I2C_BUS_SPEEDS; speed++) {
+        if (dev->bus->timings[speed].baudrate) {
+            dev->speed = speed;
+            dev->fallbacks++;
+            break;
+        }
+    }
+}
+
+typedef struct {
+    i2c_xfer_t xfer;
+    TaskHandle_t waiter;
+    int result;
+} i2c_blocking_xfer_t;
+
+static void i2c_dev_blocking_done(i2c_xfer_t *xfer, int result) {
+    i2c_blocking_xfer_t *b = xfer->ctx;
+
+    b->result = result;
+    xTaskNotifyGiveIndexed(b->waiter, I2C_BUS_DONE_INDEX);
+}
+
+static int i2c_dev_xfer_blocking(i2c_dev_t *dev, const uint8_t *tx, size_t tx_len,
+                                 uint8_t *rx, size_t rx_len) {
+    // Before the scheduler runs there is no bus task, use the controller directly
+    if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+        uint64_t start = time_us_64();
+        int result = PICO_OK;
+
+        if (dev->bus->applied != dev->speed) {
+            i2c_get_hw(dev->bus->i2c)->enable = 0;
+            i2c_bus_apply_timing(dev->bus, dev->speed);
+            i2c_get_hw(dev->bus->i2c)->enable = 1;
+        }
+        if (tx_len && i2c_write_blocking(dev->bus->i2c, dev->addr, tx, tx_len, rx_len != 0) < 0) {
+            result = PICO_ERROR_GENERIC;
+        }
+        if (result == PICO_OK && rx_len && i2c_read_blocking(dev->bus->i2c, dev->addr, rx, rx_len, false) < 0) {
+            result = PICO_ERROR_GENERIC;
+        }
+        i2c_dev_account(dev, tx_len + rx_len, time_us_64() - start, result);
+        return result;
+    }
+
+    i2c_blocking_xfer_t b = {
+        .xfer = {
+            .dev = dev,
+            .tx = tx,
+            .tx_len = tx_len,
+            .rx = rx,
+            .rx_len = rx_len,
+            .done = i2c_dev_blocking_done,
+            .ctx = &b,
+        },
+        .waiter = xTaskGetCurrentTaskHandle(),
+    };
+
+    while (!i2c_bus_submit(&b.xfer)) {
+        vTaskDelay(1);
+    }
+    ulTaskNotifyTakeIndexed(I2C_BUS_DONE_INDEX, pdTRUE, portMAX_DELAY);
+    return b.result;
+}
+
+// Writes longer than one transfer are split, each piece ends with a STOP
+int i2c_dev_write_blocking(i2c_dev_t *dev, const uint8_t *buf, size_t len) {
+    while (len) {
+        size_t n = MIN(len, I2C_BUS_MAX_XFER);
+        int result = i2c_dev_xfer_blocking(dev, buf, n, NULL, 0);
+
+        if (result != PICO_OK) {
+            return result;
+        }
+        buf += n;
+        len -= n;
+    }
+    return PICO_OK;
+}
+
+int i2c_dev_read_blocking(i2c_dev_t *dev, uint8_t *buf, size_t len) {
+    if (len > I2C_BUS_MAX_XFER) {
+        return PICO_ERROR_GENERIC;
+    }
+    return i2c_dev_xfer_blocking(dev, NULL, 0, buf, len);
+}
+
+static bool i2c_dev_check(i2c_dev_t *dev, const uint8_t *pattern, size_t len) {
+    uint8_t rd;
+
+    for (int round = 0; round < I2C_BUS_PROBE_ROUNDS; round++) {
+        if (len == 0 && i2c_dev_read_blocking(dev, &rd, 1) != PICO_OK) {
+            return false;
+        }
+        for (size_t i = 0; i < len; i++) {
+            if (i2c_dev_write_blocking(dev, &pattern[i], 1) != PICO_OK
+                || i2c_dev_read_blocking(dev, &rd, 1) != PICO_OK
+                || rd != pattern[i]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Tries each speed up to max_baudrate from the fastest down and keeps the
+// first where every round passes. Each pattern byte is written and read
+// back, with no pattern a one byte read just checks the ACK. The check only
+// proves the bus and the device's pins, limits of whatever sits behind
+// them go in max_baudrate. Returns the chosen baudrate, or 0 with the
+// device left at the bus default.
+uint i2c_dev_negotiate(i2c_dev_t *dev, uint max_baudrate, const uint8_t *pattern, size_t len) {
+    for (int speed = 0; speed < I2C_BUS_SPEEDS; speed++) {
+        if (dev->bus->timings[speed].baudrate == 0
+            || dev->bus->timings[speed].baudrate > max_baudrate) {
+            continue;
+        }
+        dev->speed = speed;
+        dev->error_run = 0;
+        if (i2c_dev_check(dev, pattern, len)) {
+            return dev->bus->timings[speed].baudrate;
+        }
+    }
+
+    dev->speed = dev->bus->default_speed;
+    dev->error_run = 0;
+    return 0;
+}
+
+uint i2c_dev_baudrate(const i2c_dev_t *dev) {
+    return dev->bus->timings[dev->speed].baudrate;
+}
+
+// Per-device share of wall time spent on the bus since i2c_bus_init()
+void i2c_bus_print_stats(i2c_bus_t *bus) {
+    uint64_t elapsed_us = time_us_64() - bus->start_us;
+
+    for (i2c_dev_t *dev = bus->devs; dev; dev = dev->next) {
+        uint64_t permille = elapsed_us ? dev->busy_us * 1000 / elapsed_us : 0;
+
+        printf("i2c%d 0x%02x: %u kHz, %lu xfers, %lu bytes, %lu errors, %lu fallbacks, %llu.%llu%% busy\n",
+               i2c_hw_index(bus->i2c), dev->addr, i2c_dev_baudrate(dev) / 1000, dev->xfers,
+               dev->bytes, dev->errors, dev->fallbacks, permille / 10, permille % 10);
+    }
+}
+
+/* Handler functions */
+static i2c_xfer_t *i2c_bus_next(i2c_bus_t *bus) {
+    i2c_xfer_t *xfer;
+
+    for (int p = I2C_BUS_PRIORITIES - 1; p >= 0; p--) {
+        if (xQueueReceive(bus->queues[p], &xfer, 0) == pdTRUE) {
+            return xfer;
+        }
+    }
+    return NULL;
+}
+
+static size_t i2c_bus_encode(const i2c_xfer_t *xfer, uint16_t *cmds) {
+    size_t n = 0;
+
+    for (size_t i = 0; i < xfer->tx_len; i++) {
+        cmds[n++] = xfer->tx[i];
+    }
+    for (size_t i = 0; i < xfer->rx_len; i++) {
+        cmds[n] = I2C_IC_DATA_CMD_CMD_BITS;
+        if (i == 0 && xfer->tx_len) {
+            cmds[n] |= I2C_IC_DATA_CMD_RESTART_BITS;
+        }
+        n++;
+    }
+    cmds[n - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+    return n;
+}
+
+static void i2c_bus_start(i2c_bus_t *bus, const i2c_xfer_t *xfer, const uint16_t *cmds, size_t n) {
+    i2c_hw_t *hw = i2c_get_hw(bus->i2c);
+
+    hw->enable = 0;
+    hw->tar = xfer->dev->addr;
+    if (bus->applied != xfer->dev->speed) {
+        i2c_bus_apply_timing(bus, xfer->dev->speed);
+    }
+    hw->enable = 1;
+
+    (void) hw->clr_stop_det;
+    (void) hw->clr_tx_abrt;
+    hw->intr_mask = I2C_IC_INTR_MASK_M_STOP_DET_BITS | I2C_IC_INTR_MASK_M_TX_ABRT_BITS;
+
+    if (xfer->rx_len) {
+        dma_channel_transfer_to_buffer_now(bus->dma_rx, xfer->rx, xfer->rx_len);
+    }
+    dma_channel_transfer_from_buffer_now(bus->dma_tx, cmds, n);
+}
+
+static void i2c_bus_task(void* arg) {
+    i2c_bus_t *bus = arg;
+    i2c_xfer_t *cur = NULL;
+    size_t cur_len = 0;
+    int buf = 0;
+
+    while (true) {
+        if (cur == NULL) {
+            cur = i2c_bus_next(bus);
+            if (cur == NULL) {
+                ulTaskNotifyTakeIndexed(I2C_BUS_SUBMIT_INDEX, pdTRUE, portMAX_DELAY);
+                continue;
+            }
+            cur_len = i2c_bus_encode(cur, bus->cmds[buf]);
+        }
+
+        uint64_t start = time_us_64();
+        i2c_bus_start(bus, cur, bus->cmds[buf], cur_len);
+
+        // Encode the next transfer while this one is on the bus
+        i2c_xfer_t *next = i2c_bus_next(bus);
+        size_t next_len = next ? i2c_bus_encode(next, bus->cmds[buf ^ 1]) : 0;
+
+        ulTaskNotifyTakeIndexed(I2C_BUS_DONE_INDEX, pdTRUE, portMAX_DELAY);
+        if (cur->rx_len && bus->result == PICO_OK) {
+            dma_channel_wait_for_finish_blocking(bus->dma_rx);
+        }
+
+        i2c_dev_account(cur->dev, cur->tx_len + cur->rx_len, time_us_64() - start, bus->result);
+        if (cur->done) {
+            cur->done(cur, bus->result);
+        }
+
+        cur = next;
+        cur_len = next_len;
+        buf ^= 1;
+    }
+}
+
+/* Interrupt handlers */
+static void i2c_bus_irq(i2c_bus_t *bus) {
+    i2c_hw_t *hw = i2c_get_hw(bus->i2c);
+    BaseType_t woken = pdFALSE;
+
+    bus->result = PICO_OK;
+    if (hw->intr_stat & I2C_IC_INTR_STAT_R_TX_ABRT_BITS) {
+        // Stop the DMA before the abort is cleared, or the rest of the
+        // buffer would go out as a new transfer
+        dma_channel_abort(bus->dma_tx);
+        dma_channel_abort(bus->dma_rx);
+        (void) hw->clr_tx_abrt;
+        bus->result = PICO_ERROR_GENERIC;
+    }
+    (void) hw->clr_stop_det;
+    hw->intr_mask = 0;
+
+    vTaskNotifyGiveIndexedFromISR(bus->task, I2C_BUS_DONE_INDEX, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+static void i2c_bus_irq0(void) {
+    i2c_bus_irq(i2c_buses[0]);
+}
+
+static void i2c_bus_irq1(void) {
+    i2c_bus_irq(i2c_buses[1]);
+}
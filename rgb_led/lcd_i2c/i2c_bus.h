@@ -0,0 +1,114 @@
+/**
+ * @brief Shared I2C bus manager
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <FreeRTOS.h>
+#include <queue.h>
+#include <task.h>
+
+#include "hardware/i2c.h"
+
+// Transfers are encoded into 16-bit IC_DATA_CMD entries, one per byte
+#define I2C_BUS_MAX_XFER        256
+#define I2C_BUS_QUEUE_LEN       8
+
+// Device priorities, higher is served first
+#define I2C_BUS_PRIO_LOW        0
+#define I2C_BUS_PRIO_NORMAL     1
+#define I2C_BUS_PRIO_HIGH       2
+#define I2C_BUS_PRIORITIES      3
+
+// Negotiated speeds, fastest first: Fast-mode Plus, Fast-mode, Standard
+#define I2C_BUS_SPEEDS          3
+
+// A device drops to the next slower speed after this many failed
+// transfers in a row, and negotiation runs each check this many times
+#define I2C_BUS_FALLBACK_ERRORS 3
+#define I2C_BUS_PROBE_ROUNDS    4
+
+// Bus task wakes on index 1 for new work, transfer completion is index 2
+// for the bus task and for callers blocked in i2c_dev_*_blocking()
+#define I2C_BUS_SUBMIT_INDEX    1
+#define I2C_BUS_DONE_INDEX      2
+
+typedef struct i2c_bus i2c_bus_t;
+typedef struct i2c_dev i2c_dev_t;
+typedef struct i2c_xfer i2c_xfer_t;
+
+// Runs in the bus task, result is PICO_OK or PICO_ERROR_GENERIC on abort
+typedef void (*i2c_xfer_callback_t)(i2c_xfer_t *xfer, int result);
+
+// SCL counts for one speed, baudrate is 0 when the pull-ups cannot reach it
+typedef struct {
+    uint baudrate;
+    uint16_t hcnt;
+    uint16_t lcnt;
+    uint8_t spklen;
+    uint16_t sda_hold;
+} i2c_timing_t;
+
+struct i2c_dev {
+    i2c_bus_t *bus;
+    i2c_dev_t *next;
+    uint8_t addr;
+    uint8_t priority;
+    uint8_t speed;          // Index into bus->timings
+    uint8_t error_run;      // Failed transfers in a row at this speed
+
+    uint32_t xfers;
+    uint32_t bytes;
+    uint32_t errors;
+    uint32_t fallbacks;
+    uint64_t busy_us;
+};
+
+// Caller owns the transfer and its buffers until the callback has run
+struct i2c_xfer {
+    i2c_dev_t *dev;
+    const uint8_t *tx;
+    size_t tx_len;
+    uint8_t *rx;
+    size_t rx_len;
+    i2c_xfer_callback_t done;
+    void *ctx;
+};
+
+struct i2c_bus {
+    i2c_inst_t *i2c;
+    i2c_dev_t *devs;
+    int dma_tx;
+    int dma_rx;
+    TaskHandle_t task;
+    QueueHandle_t queues[I2C_BUS_PRIORITIES];
+    uint64_t start_us;
+    volatile int result;
+
+    // Timing is switched per device while the controller is disabled
+    i2c_timing_t timings[I2C_BUS_SPEEDS];
+    uint8_t default_speed;
+    int applied;
+
+    // Next transfer is encoded into the idle buffer while one is on the bus
+    uint16_t cmds[2][I2C_BUS_MAX_XFER];
+};
+
+void i2c_bus_init(i2c_bus_t *bus, i2c_inst_t *i2c, uint baudrate, uint sda, uint scl,
+                  uint rise_ns, UBaseType_t task_priority);
+void i2c_dev_init(i2c_dev_t *dev, i2c_bus_t *bus, uint8_t addr, uint8_t priority);
+
+bool i2c_bus_submit(i2c_xfer_t *xfer);
+int i2c_dev_write_blocking(i2c_dev_t *dev, const uint8_t *buf, size_t len);
+int i2c_dev_read_blocking(i2c_dev_t *dev, uint8_t *buf, size_t len);
+
+uint i2c_dev_negotiate(i2c_dev_t *dev, uint max_baudrate, const uint8_t *pattern, size_t len);
+uint i2c_dev_baudrate(const i2c_dev_t *dev);
+
+void i2c_bus_print_stats(i2c_bus_t *bus);
@@ -0,0 +1,45 @@
+/**
+ * @brief HD44780 LCD driver interface
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "constants.h"
+#include "i2c_bus.h"
+
+// How the driver waits for a command to finish
+typedef enum {
+    LCD_TIMING_FIXED,   // LCD_COMMAND_DELAY_US after every command
+    LCD_TIMING_TABLE,   // Datasheet execution time of each command
+    LCD_TIMING_BUSY,    // Poll the busy flag over the expander R/W line
+} lcd_timing_t;
+
+typedef struct {
+    i2c_dev_t *dev;
+    lcd_timing_t timing;
+} lcd_display_t;
+
+// Canned screen compiled by lcd_msgc.py, lines are centered and padded and
+// bytes is the whole screen as one expander stream, cursor moves included
+typedef struct {
+    const char *lines[MAX_LINES];
+    const uint8_t *bytes;
+    size_t len;
+} lcd_screen_t;
+
+void lcd_select(lcd_display_t *display);
+void lcd_init(void);
+void lcd_set_timing(lcd_timing_t timing);
+void lcd_clear(void);
+void lcd_toggle_enable(uint8_t val);
+void lcd_send_byte(uint8_t val, int mode);
+void lcd_set_cursor(int line, int position);
+void lcd_write(const char *s, size_t len);
+void lcd_string(const char *s);
+void lcd_show_screen(const lcd_screen_t *screen);
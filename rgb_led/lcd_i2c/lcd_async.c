@@ -0,0 +1,177 @@
+/**
+ * @brief Asynchronous LCD service task
+ *
+ * Draw requests are copied into a queue and return immediately. A single
+ * service task owns the display and runs the normal lcd_* functions, whose
+ * encoded expander bytes go out through the I2C bus manager by DMA. The
+ * service task sleeps while a transfer is on the bus, so other tasks keep
+ * running for the whole refresh.
+ *
+ * A wait that times out leaves its request queued, and the service task
+ * still notifies for it later. Each wait sends a sequence number and the
+ * service task notifies with it, so a waiter only returns for its own.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include <string.h>
+#include <queue.h>
+
+#include "pico/stdlib.h"
+
+#include "constants.h"
+#include "lcd.h"
+#include "lcd_async.h"
+
+/* Types */
+typedef enum {
+    LCD_ASYNC_STRING,
+    LCD_ASYNC_CLEAR,
+    LCD_ASYNC_FLUSH,
+    LCD_ASYNC_SCREEN,
+    LCD_ASYNC_MARQUEE_LOAD,
+    LCD_ASYNC_MARQUEE_STEP,
+    LCD_ASYNC_SYNC,
+} lcd_async_op_t;
+
+typedef struct {
+    lcd_async_op_t op;
+    int8_t line;
+    int8_t position;
+    union {
+        char text[LCD_ASYNC_MAX_CHARS + 1];
+        lcd_fb_t *fb;
+        const lcd_screen_t *screen;
+        lcd_marquee_t *marquee;
+        struct {
+            TaskHandle_t task;
+            uint32_t seq;
+        } notify;
+    };
+} lcd_async_cmd_t;
+
+/* Globals */
+static QueueHandle_t lcd_async_queue;
+static TaskHandle_t lcd_async_task;
+static uint32_t lcd_async_seq;
+
+/* Prototypes */
+static void lcd_async_service(void* unused);
+
+/* Code */
+void lcd_async_init(UBaseType_t priority) {
+    lcd_async_queue = xQueueCreate(LCD_ASYNC_QUEUE_LEN, sizeof(lcd_async_cmd_t));
+
+    xTaskCreate(lcd_async_service, "LCD_Task", 256, NULL, priority, &lcd_async_task);
+}
+
+bool lcd_async_in_service_task(void) {
+    return lcd_async_task != NULL
+        && xTaskGetSchedulerState() == taskSCHEDULER_RUNNING
+        && xTaskGetCurrentTaskHandle() == lcd_async_task;
+}
+
+bool lcd_write_async(int line, int position, const char *s) {
+    lcd_async_cmd_t cmd = { .op = LCD_ASYNC_STRING, .line = line, .position = position };
+
+    strncpy(cmd.text, s, LCD_ASYNC_MAX_CHARS);
+    cmd.text[LCD_ASYNC_MAX_CHARS] = '\0';
+    return xQueueSend(lcd_async_queue, &cmd, 0) == pdTRUE;
+}
+
+bool lcd_clear_async(void) {
+    lcd_async_cmd_t cmd = { .op = LCD_ASYNC_CLEAR };
+
+    return xQueueSend(lcd_async_queue, &cmd, 0) == pdTRUE;
+}
+
+// The service task reads fb->draw when it reaches this request
+bool lcd_fb_flush_async(lcd_fb_t *fb) {
+    lcd_async_cmd_t cmd = { .op = LCD_ASYNC_FLUSH, .fb = fb };
+
+    return xQueueSend(lcd_async_queue, &cmd, 0) == pdTRUE;
+}
+
+bool lcd_show_screen_async(const lcd_screen_t *screen) {
+    lcd_async_cmd_t cmd = { .op = LCD_ASYNC_SCREEN, .screen = screen };
+
+    return xQueueSend(lcd_async_queue, &cmd, 0) == pdTRUE;
+}
+
+// The service task owns m until lcd_async_wait() returns
+bool lcd_marquee_load_async(lcd_marquee_t *m) {
+    lcd_async_cmd_t cmd = { .op = LCD_ASYNC_MARQUEE_LOAD, .marquee = m };
+
+    return xQueueSend(lcd_async_queue, &cmd, 0) == pdTRUE;
+}
+
+bool lcd_marquee_step_async(lcd_marquee_t *m) {
+    lcd_async_cmd_t cmd = { .op = LCD_ASYNC_MARQUEE_STEP, .marquee = m };
+
+    return xQueueSend(lcd_async_queue, &cmd, 0) == pdTRUE;
+}
+
+bool lcd_async_wait(TickType_t timeout) {
+    lcd_async_cmd_t cmd = { .op = LCD_ASYNC_SYNC };
+    TimeOut_t start;
+    uint32_t seq;
+
+    cmd.notify.task = xTaskGetCurrentTaskHandle();
+    cmd.notify.seq = __atomic_add_fetch(&lcd_async_seq, 1, __ATOMIC_RELAXED);
+
+    // Anything left from a wait that timed out is not for this one
+    xTaskNotifyStateClearIndexed(NULL, LCD_ASYNC_NOTIFY_INDEX);
+    vTaskSetTimeOutState(&start);
+    if (xQueueSend(lcd_async_queue, &cmd, timeout) != pdTRUE) {
+        return false;
+    }
+    xTaskCheckForTimeOut(&start, &timeout);
+    while (xTaskNotifyWaitIndexed(LCD_ASYNC_NOTIFY_INDEX, 0, 0, &seq, timeout) == pdTRUE) {
+        if (seq == cmd.notify.seq) {
+            return true;
+        }
+        if (xTaskCheckForTimeOut(&start, &timeout) == pdTRUE) {
+            break;
+        }
+    }
+    return false;
+}
+
+/* Handler functions */
+static void lcd_async_service(void* unused) {
+    lcd_async_cmd_t cmd;
+
+    while (true) {
+        xQueueReceive(lcd_async_queue, &cmd, portMAX_DELAY);
+
+        switch (cmd.op) {
+            case LCD_ASYNC_STRING:
+                lcd_set_cursor(cmd.line, cmd.position);
+                lcd_string(cmd.text);
+                break;
+            case LCD_ASYNC_CLEAR:
+                lcd_clear();
+                break;
+            case LCD_ASYNC_FLUSH:
+                lcd_fb_flush(cmd.fb);
+                break;
+            case LCD_ASYNC_SCREEN:
+                lcd_show_screen(cmd.screen);
+                break;
+            case LCD_ASYNC_MARQUEE_LOAD:
+                lcd_marquee_load(cmd.marquee);
+                break;
+            case LCD_ASYNC_MARQUEE_STEP:
+                lcd_marquee_step(cmd.marquee);
+                break;
+            case LCD_ASYNC_SYNC:
+                xTaskNotifyIndexed(cmd.notify.task, LCD_ASYNC_NOTIFY_INDEX, cmd.notify.seq,
+                                   eSetValueWithOverwrite);
+                break;
+        }
+    }
+}
+
@@ -0,0 +1,36 @@
+/**
+ * @brief Asynchronous LCD service task
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <FreeRTOS.h>
+#include <task.h>
+
+#include "lcd.h"
+#include "lcd_fb.h"
+#include "lcd_marquee.h"
+
+// Notification index used for request completion, index 0 is left to the
+// application
+#define LCD_ASYNC_NOTIFY_INDEX  1
+
+void lcd_async_init(UBaseType_t priority);
+bool lcd_async_in_service_task(void);
+
+// Non-blocking, return false when the queue is full
+bool lcd_write_async(int line, int position, const char *s);
+bool lcd_clear_async(void);
+bool lcd_fb_flush_async(lcd_fb_t *fb);
+bool lcd_show_screen_async(const lcd_screen_t *screen);
+bool lcd_marquee_load_async(lcd_marquee_t *m);
+bool lcd_marquee_step_async(lcd_marquee_t *m);
+
+// Blocks the calling task until everything queued before it has gone out
+bool lcd_async_wait(TickType_t timeout);
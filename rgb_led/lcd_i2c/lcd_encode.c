@@ -0,0 +1,40 @@
+/**
+ * @brief HD44780 to PCF8574 expander byte stream encoding
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "constants.h"
+#include "lcd_encode.h"
+
+/* Code */
+static inline size_t lcd_encode_nibble(uint8_t *buf, uint8_t val) {
+    buf[0] = val;
+    buf[1] = val | LCD_ENABLE_BIT;
+    buf[2] = val & ~LCD_ENABLE_BIT;
+    return 3;
+}
+
+// Same expander bytes lcd_send_byte() writes, minus the delays in between
+size_t lcd_encode_byte(uint8_t *buf, uint8_t val, int mode) {
+    uint8_t high = mode | (val & 0xF0) | LCD_BACKLIGHT;
+    uint8_t low = mode | ((val << 4) & 0xF0) | LCD_BACKLIGHT;
+    size_t len = 0;
+
+    len += lcd_encode_nibble(&buf[len], high);
+    len += lcd_encode_nibble(&buf[len], low);
+    return len;
+}
+
+// buf must hold n * LCD_ENCODED_BYTE_LEN bytes
+size_t lcd_encode_bytes(uint8_t *buf, const uint8_t *bytes, size_t n, int mode) {
+    size_t len = 0;
+
+    while (n--) {
+        len += lcd_encode_byte(&buf[len], *bytes++, mode);
+    }
+    return len;
+}
@@ -0,0 +1,17 @@
+/**
+ * @brief HD44780 to PCF8574 expander byte stream encoding
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Each HD44780 byte is two nibbles, each sent as data, E high, E low
+#define LCD_ENCODED_BYTE_LEN    6
+
+size_t lcd_encode_byte(uint8_t *buf, uint8_t val, int mode);
+size_t lcd_encode_bytes(uint8_t *buf, const uint8_t *bytes, size_t n, int mode);
@@ -0,0 +1,111 @@
+/**
+ * @brief Shadow framebuffer for the HD44780 LCD
+ *
+ * Callers draw into RAM, lcd_fb_flush() then sends only the runs of cells
+ * that differ from what the display already shows. Nothing here ever
+ * clears the display, so updates do not flicker.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include <string.h>
+
+#include "lcd.h"
+#include "lcd_fb.h"
+#include "lcd_glyph.h"
+
+/* Code */
+// Assumes the display was just cleared, as lcd_init() leaves it
+void lcd_fb_init(lcd_fb_t *fb, int rows, int cols) {
+    fb->rows = MIN(rows, LCD_FB_MAX_ROWS);
+    fb->cols = MIN(cols, LCD_FB_MAX_COLS);
+    memset(fb->draw, ' ', sizeof(fb->draw));
+    memset(fb->shown, ' ', sizeof(fb->shown));
+    fb->cursor_row = -1;
+    fb->cursor_col = 0;
+    fb->cells_sent = 0;
+    fb->cursor_moves = 0;
+}
+
+// Forget what the display holds so the next flush rewrites every cell
+void lcd_fb_invalidate(lcd_fb_t *fb) {
+    for (int row = 0; row < fb->rows; row++) {
+        for (int col = 0; col < fb->cols; col++) {
+            fb->shown[row][col] = ~fb->draw[row][col];
+        }
+    }
+    fb->cursor_row = -1;
+}
+
+void lcd_fb_clear(lcd_fb_t *fb) {
+    memset(fb->draw, ' ', sizeof(fb->draw));
+}
+
+void lcd_fb_put(lcd_fb_t *fb, int row, int col, char c) {
+    if (row < 0 || row >= fb->rows || col < 0 || col >= fb->cols) {
+        return;
+    }
+    fb->draw[row][col] = c;
+}
+
+// Text running off the end of the row is clipped
+void lcd_fb_print(lcd_fb_t *fb, int row, int col, const char *s) {
+    while (*s && col < fb->cols) {
+        lcd_fb_put(fb, row, col++, *s++);
+    }
+}
+
+static void lcd_fb_send_run(lcd_fb_t *fb, int row, int start, int end) {
+    if (fb->cursor_row != row || fb->cursor_col != start) {
+        lcd_set_cursor(row, start);
+        fb->cursor_moves++;
+    }
+
+    lcd_write(&fb->draw[row][start], end - start);
+    memcpy(&fb->shown[row][start], &fb->draw[row][start], end - start);
+
+    fb->cells_sent += end - start;
+    fb->cursor_row = row;
+    fb->cursor_col = end;
+}
+
+void lcd_fb_flush(lcd_fb_t *fb) {
+    // Glyph uploads move the address counter into CGRAM
+    if (lcd_glyph_upload_pending()) {
+        fb->cursor_row = -1;
+    }
+
+    for (int row = 0; row < fb->rows; row++) {
+        const char *draw = fb->draw[row];
+        const char *shown = fb->shown[row];
+        int col = 0;
+
+        while (col < fb->cols) {
+            // Find the next dirty cell
+            while (col < fb->cols && draw[col] == shown[col]) {
+                col++;
+            }
+            if (col == fb->cols) {
+                break;
+            }
+
+            // Extend the run while the clean gaps inside it are short enough
+            // that rewriting them is cheaper than another cursor move
+            int start = col;
+            int end = col + 1;
+            for (col = end; col < fb->cols; col++) {
+                if (draw[col] != shown[col]) {
+                    end = col + 1;
+                } else if (col - end >= LCD_FB_MERGE_GAP) {
+                    break;
+                }
+            }
+
+            lcd_fb_send_run(fb, row, start, end);
+            col = end;
+        }
+    }
+}
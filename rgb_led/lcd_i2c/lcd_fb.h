@@ -0,0 +1,34 @@
+/**
+ * @brief Shadow framebuffer for the HD44780 LCD
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "constants.h"
+
+typedef struct {
+    int rows;
+    int cols;
+    char draw[LCD_FB_MAX_ROWS][LCD_FB_MAX_COLS];    // What callers want shown
+    char shown[LCD_FB_MAX_ROWS][LCD_FB_MAX_COLS];   // What DDRAM currently holds
+
+    // DDRAM address left by the last write, row -1 when unknown
+    int cursor_row;
+    int cursor_col;
+
+    // Traffic counters, cumulative since lcd_fb_init()
+    uint32_t cells_sent;
+    uint32_t cursor_moves;
+} lcd_fb_t;
+
+void lcd_fb_init(lcd_fb_t *fb, int rows, int cols);
+void lcd_fb_invalidate(lcd_fb_t *fb);
+void lcd_fb_clear(lcd_fb_t *fb);
+void lcd_fb_put(lcd_fb_t *fb, int row, int col, char c);
+void lcd_fb_print(lcd_fb_t *fb, int row, int col, const char *s);
+void lcd_fb_flush(lcd_fb_t *fb);
@@ -0,0 +1,90 @@
+/**
+ * @brief CGRAM custom glyph cache
+ *
+ * The 8 CGRAM slots are managed as an LRU cache keyed on the glyph bitmap.
+ * lcd_glyph_get() only assigns a slot, the bitmap is uploaded by the next
+ * lcd_fb_flush() so uploads happen in whichever task does the flushing.
+ * Replacing a slot changes every cell still showing its old glyph.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include <string.h>
+
+#include "constants.h"
+#include "lcd.h"
+#include "lcd_glyph.h"
+
+/* Types */
+typedef struct {
+    lcd_glyph_t glyph;
+    uint32_t last_used;
+    bool valid;
+    bool pending;
+} lcd_glyph_slot_t;
+
+/* Globals */
+static lcd_glyph_slot_t lcd_glyph_slots[LCD_GLYPH_SLOTS];
+static uint32_t lcd_glyph_clock;
+
+lcd_glyph_stats_t lcd_glyph_stats;
+
+/* Code */
+// CGRAM contents are undefined after power up, call after lcd_init()
+void lcd_glyph_reset(void) {
+    memset(lcd_glyph_slots, 0, sizeof(lcd_glyph_slots));
+    lcd_glyph_clock = 0;
+}
+
+char lcd_glyph_get(const lcd_glyph_t *glyph) {
+    int victim = 0;
+
+    lcd_glyph_clock++;
+    for (int slot = 0; slot < LCD_GLYPH_SLOTS; slot++) {
+        lcd_glyph_slot_t *s = &lcd_glyph_slots[slot];
+
+        if (s->valid && memcmp(&s->glyph, glyph, sizeof(*glyph)) == 0) {
+            s->last_used = lcd_glyph_clock;
+            lcd_glyph_stats.hits++;
+            return LCD_GLYPH_CHAR(slot);
+        }
+
+        // Free slots first, then the least recently used
+        lcd_glyph_slot_t *v = &lcd_glyph_slots[victim];
+        if (v->valid && (!s->valid || s->last_used < v->last_used)) {
+            victim = slot;
+        }
+    }
+
+    lcd_glyph_slot_t *s = &lcd_glyph_slots[victim];
+    s->glyph = *glyph;
+    s->last_used = lcd_glyph_clock;
+    s->valid = true;
+    s->pending = true;
+    lcd_glyph_stats.misses++;
+    return LCD_GLYPH_CHAR(victim);
+}
+
+// Leaves the address counter in CGRAM, returns true if the caller has to
+// set the cursor again before writing characters
+bool lcd_glyph_upload_pending(void) {
+    bool uploaded = false;
+
+    for (int slot = 0; slot < LCD_GLYPH_SLOTS; slot++) {
+        lcd_glyph_slot_t *s = &lcd_glyph_slots[slot];
+
+        if (!s->pending) {
+            continue;
+        }
+        s->pending = false;
+
+        lcd_send_byte(LCD_SETCGRAMADDR | (slot << 3), LCD_COMMAND);
+        lcd_write((const char *) s->glyph.rows, sizeof(s->glyph.rows));
+        lcd_glyph_stats.uploads++;
+        uploaded = true;
+    }
+    return uploaded;
+}
@@ -0,0 +1,34 @@
+/**
+ * @brief CGRAM custom glyph cache
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LCD_GLYPH_SLOTS     8
+
+// Slot n is drawn with char code 0x08 + n, the CGRAM mirror of 0x00 + n,
+// which keeps NUL out of strings
+#define LCD_GLYPH_CHAR(slot)    ((char) (0x08 + (slot)))
+
+// 5x8 glyph, one row per byte in the low 5 bits, leftmost pixel is bit 4
+typedef struct {
+    uint8_t rows[8];
+} lcd_glyph_t;
+
+typedef struct {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t uploads;
+} lcd_glyph_stats_t;
+
+extern lcd_glyph_stats_t lcd_glyph_stats;
+
+void lcd_glyph_reset(void);
+char lcd_glyph_get(const lcd_glyph_t *glyph);
+bool lcd_glyph_upload_pending(void);
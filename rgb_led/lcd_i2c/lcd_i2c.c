@@ -7,6 +7,7 @@
  */
 
 /* Includes */
+#include <assert.h>
 #include <stdio.h>
 #include <string.h>
 #include <FreeRTOS.h>
@@ -14,9 +15,47 @@
 
 #include "hardware/gpio.h"
 #include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
 #include "hardware/i2c.h"
+#include "hardware/adc.h"
 
 #include "constants.h"
+#include "i2c_bus.h"
+#include "lcd.h"
+#include "lcd_async.h"
+#include "lcd_encode.h"
+#include "lcd_fb.h"
+#include "lcd_glyph.h"
+#include "lcd_marquee.h"
+#include "lcd_oled.h"
+#include "lcd_pio.h"
+#include "lcd_timing.h"
+#include "lcd_widget.h"
+#include "lcd_messages.h"
+
+/* Globals */
+static i2c_bus_t lcd_bus;
+static i2c_dev_t lcd_dev;
+
+static lcd_display_t lcd_default_display = {
+    .dev = &lcd_dev,
+    .timing = LCD_TIMING_DEFAULT,
+};
+static lcd_display_t *lcd_display = &lcd_default_display;
+
+#if LCD_BACKEND != LCD_BACKEND_PIO
+// Negotiated before USB enumerates, the heartbeat prints it later
+static uint lcd_speed_khz;
+#endif
+
+#if LCD_BACKEND == LCD_BACKEND_I2C
+static uint8_t lcd_batch_buf[LCD_BATCH_MAX_CHARS * LCD_ENCODED_BYTE_LEN];
+
+// See LCD_I2C_MAX_BAUD, characters in a stream are not padded
+static_assert(3 * 9 * 1000000 / LCD_I2C_MAX_BAUD
+              >= (37 + 4) * (100 + LCD_TIMING_MARGIN_PCT) / 100,
+              "batched characters need 3 bus bytes per execution time");
+#endif
 
 /* Prototypes */
 void hardware_init(void);
@@ -24,14 +63,14 @@ void i2c_write_byte(uint8_t val);
 
 void task_heartbeat(void* unused);
 void task_print_msg(void* unused);
+void task_level_meter(void* unused);
+void task_marquee(void* unused);
 
-void lcd_init(void);
-void lcd_clear(void);
-void lcd_toggle_enable(uint8_t val);
-void lcd_send_byte(uint8_t val, int mode);
-void lcd_set_cursor(int line, int position);
 static void inline lcd_char(char val);
-void lcd_string(const char *s);
+static void lcd_delay_us(uint32_t us);
+#if LCD_TIMING_BENCHMARK
+static void lcd_timing_benchmark_print(void);
+#endif
 
 
 /* Code */
@@ -42,8 +81,15 @@ int main()
     hardware_init();
 
     printf("create tasks\n");
+    lcd_async_init(2);
     xTaskCreate(task_heartbeat, "LED_Task", 256, NULL, tskIDLE_PRIORITY, NULL);
+#if LCD_DEMO_LEVEL_METER
+    xTaskCreate(task_level_meter, "METER_Task", 256, NULL, 1, NULL);
+#elif LCD_DEMO_MARQUEE
+    xTaskCreate(task_marquee, "MARQUEE_Task", 256, NULL, 1, NULL);
+#else
     xTaskCreate(task_print_msg, "PRINTMSG_Task", 256, NULL, 1, NULL);
+#endif
 
     printf("start scheduler\n");
     vTaskStartScheduler();
@@ -55,8 +101,30 @@ int main()
 /* Handler functions */
 void task_heartbeat(void* notUsed)
 {   
-    while (true) {
+#if LCD_BACKEND != LCD_BACKEND_PIO
+    bool speed_printed = false;
+#endif
+#if LCD_TIMING_BENCHMARK
+    bool bench_printed = false;
+#endif
+
+    for (uint32_t beat = 0; ; beat++) {
         printf("hb-tick: %d\n", HEARTBEAT_DELAY_MS);
+#if LCD_BACKEND != LCD_BACKEND_PIO
+        if (!speed_printed && stdio_usb_connected()) {
+            printf("lcd i2c: %u kHz\n", lcd_speed_khz);
+            speed_printed = true;
+        }
+#endif
+#if LCD_TIMING_BENCHMARK
+        if (!bench_printed && stdio_usb_connected()) {
+            lcd_timing_benchmark_print();
+            bench_printed = true;
+        }
+#endif
+        if (beat % I2C_STATS_BEATS == 0) {
+            i2c_bus_print_stats(&lcd_bus);
+        }
         gpio_put(PICO_DEFAULT_LED_PIN, 1);
         vTaskDelay(HEARTBEAT_DELAY_MS);
         gpio_put(PICO_DEFAULT_LED_PIN, 0);
@@ -66,26 +134,113 @@ void task_heartbeat(void* notUsed)
 
 void task_print_msg(void* unused)
 {
-    static char *message[] = {
-            "lmao kiddo", "try harder"
-        };
+#if LCD_CANNED_SCREENS
+    // Screens were centered and encoded at build time, each one is a
+    // single transmit with no per-character work
+    while (true) {
+        for (int m = 0; m < LCD_SCREEN_COUNT; m++) {
+            absolute_time_t start = get_absolute_time();
+
+            lcd_show_screen_async(&lcd_screens[m]);
+            int64_t queue_us = absolute_time_diff_us(start, get_absolute_time());
+
+            lcd_async_wait(portMAX_DELAY);
+            printf("lcd screen: %lld us queued, %lld us total, %u bytes\n",
+                   queue_us, absolute_time_diff_us(start, get_absolute_time()),
+                   (unsigned)lcd_screens[m].len);
+            vTaskDelay(2000);
+        }
+    }
+#else
+    static lcd_fb_t fb;
+
+    lcd_fb_init(&fb, MAX_LINES, MAX_CHARS);
 
     while (true) {
-        for (int m = 0; m < sizeof(message) / sizeof(message[0]); m += MAX_LINES) {
+        for (int m = 0; m < LCD_SCREEN_COUNT; m++) {
+            absolute_time_t start = get_absolute_time();
+
+            // Redraw in RAM, only cells that differ from the display go out.
+            // The LCD task does the flush, fb is left alone until it is done.
             for (int line = 0; line < MAX_LINES; line++) {
-                lcd_set_cursor(line, (MAX_CHARS / 2) - strlen(message[m + line]) / 2);
-                lcd_string(message[m + line]);
+                lcd_fb_print(&fb, line, 0, lcd_screens[m].lines[line]);
             }
+            lcd_fb_flush_async(&fb);
+            int64_t queue_us = absolute_time_diff_us(start, get_absolute_time());
+
+            lcd_async_wait(portMAX_DELAY);
+            printf("lcd redraw: %lld us queued, %lld us total, %lu cells, %lu moves\n",
+                   queue_us, absolute_time_diff_us(start, get_absolute_time()),
+                   fb.cells_sent, fb.cursor_moves);
             vTaskDelay(2000);
-            lcd_clear();
+        }
+    }
+#endif
+}
+
+// Live ADC level on a sub-cell bar, glyph traffic is reported once a second
+void task_level_meter(void* unused)
+{
+    static lcd_fb_t fb;
+    char text[MAX_CHARS + 1];
+    TickType_t last_wake = xTaskGetTickCount();
+
+    lcd_fb_init(&fb, MAX_LINES, MAX_CHARS);
+
+    for (uint32_t frame = 0; ; frame++) {
+        uint16_t level = adc_read();
+
+        // Previous flush has to finish reading fb before it is redrawn
+        lcd_async_wait(portMAX_DELAY);
+        snprintf(text, sizeof(text), "Level %4u/4095", level);
+        lcd_fb_print(&fb, 0, 0, text);
+        lcd_bar_draw(&fb, 1, 0, MAX_CHARS, level, 4095);
+        lcd_fb_flush_async(&fb);
+
+        if (frame % LCD_METER_FPS == 0) {
+            printf("glyph hits %lu, misses %lu, uploads %lu, cells %lu\n",
+                   lcd_glyph_stats.hits, lcd_glyph_stats.misses,
+                   lcd_glyph_stats.uploads, fb.cells_sent);
+        }
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(1000 / LCD_METER_FPS));
+    }
+}
+
+// Ticker across the top line, each step is one shift command plus at most
+// one patched column
+void task_marquee(void* unused)
+{
+    static const char text[] =
+        "lmao kiddo, try harder. this line is longer than the display RAM";
+    static lcd_marquee_t marquee;
+    TickType_t last_wake = xTaskGetTickCount();
+
+    lcd_marquee_init(&marquee, 0, text, 1);
+    lcd_marquee_load_async(&marquee);
+
+    for (uint32_t step = 1; ; step++) {
+        lcd_marquee_step_async(&marquee);
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(LCD_MARQUEE_STEP_MS));
+
+        // Counters are only read once the service task is done with them
+        if (step % marquee.period == 0) {
+            lcd_async_wait(portMAX_DELAY);
+            printf("marquee: %lu steps, %lu patched columns\n",
+                   marquee.steps, marquee.patches);
         }
     }
 }
 
 /* LCD functions */
+// Point the lcd_* functions at another display, e.g. a second LCD on the bus
+void lcd_select(lcd_display_t *display) {
+    lcd_display = display;
+}
+
 void lcd_init()
 {
     lcd_send_byte(0x03, LCD_COMMAND);
+    lcd_delay_us(LCD_INIT_DELAY_US);
     lcd_send_byte(0x03, LCD_COMMAND);
     lcd_send_byte(0x03, LCD_COMMAND);
     lcd_send_byte(0x02, LCD_COMMAND);
@@ -96,9 +251,108 @@ void lcd_init()
     lcd_clear();
 }
 
+void lcd_set_timing(lcd_timing_t timing) {
+    lcd_display->timing = timing;
+}
+
+// The bus manager sends by DMA once the scheduler runs, callers sleep meanwhile
+static void lcd_transmit(const uint8_t *buf, size_t len) {
+    i2c_dev_write_blocking(lcd_display->dev, buf, len);
+}
+
+// Long waits in the LCD service task sleep instead of spinning
+static void lcd_delay_us(uint32_t us) {
+    if (us >= 1000 && lcd_async_in_service_task()) {
+        vTaskDelay(pdMS_TO_TICKS((us + 999) / 1000) + 1);
+    } else {
+        sleep_us(us);
+    }
+}
+
+#if LCD_BACKEND == LCD_BACKEND_PIO
+static void lcd_backend_write(const uint8_t *bytes, size_t n, int mode) {
+    lcd_pio_write(bytes, n, mode);
+}
+#elif LCD_BACKEND == LCD_BACKEND_OLED
+static void lcd_backend_write(const uint8_t *bytes, size_t n, int mode) {
+    lcd_oled_write(bytes, n, mode);
+}
+#else
+// Bytes are encoded to expander writes up front and sent as one transaction
+static void lcd_backend_write(const uint8_t *bytes, size_t n, int mode) {
+    size_t len = lcd_encode_bytes(lcd_batch_buf, bytes, n, mode);
+
+    lcd_transmit(lcd_batch_buf, len);
+}
+
+// Read the busy flag back through the expander, a read clocks both nibbles
+static bool lcd_read_busy(void) {
+    uint8_t rd = 0xF0 | LCD_RW_BIT | LCD_BACKLIGHT;
+    uint8_t strobe[] = { rd, rd | LCD_ENABLE_BIT };
+    uint8_t finish[] = { rd, rd | LCD_ENABLE_BIT, rd };
+    uint8_t status;
+
+    i2c_dev_write_blocking(lcd_display->dev, strobe, sizeof(strobe));
+    i2c_dev_read_blocking(lcd_display->dev, &status, 1);
+    i2c_dev_write_blocking(lcd_display->dev, finish, sizeof(finish));
+    return status & 0x80;
+}
+#endif
+
+#if LCD_BACKEND == LCD_BACKEND_I2C
+// Address plus data, E high and E low bytes, 9 bit times each
+static uint32_t lcd_bus_slack_us(void) {
+    return 4 * 9 * 1000000 / i2c_dev_baudrate(lcd_display->dev);
+}
+#elif LCD_BACKEND == LCD_BACKEND_PIO
+static uint32_t lcd_bus_slack_us(void) {
+    return LCD_TIMING_BUS_SLACK_US;
+}
+#endif
+
+#if LCD_BACKEND == LCD_BACKEND_OLED
+// Emulated commands are done once they are drawn
+static void lcd_wait_ready(uint8_t val, int mode) {
+}
+#else
+// Wait out whatever the next transfer's own bus time will not cover
+static void lcd_wait_ready(uint8_t val, int mode) {
+    uint32_t exec_us = lcd_exec_time_us(val, mode);
+    uint32_t slack_us = lcd_bus_slack_us();
+
+    switch (lcd_display->timing) {
+        case LCD_TIMING_FIXED:
+            if (mode == LCD_COMMAND) {
+                lcd_delay_us(LCD_COMMAND_DELAY_US);
+            }
+            break;
+#if LCD_BACKEND == LCD_BACKEND_PIO
+        // R/W is tied low, there is no busy flag to read
+        case LCD_TIMING_BUSY:
+#endif
+        case LCD_TIMING_TABLE:
+            if (exec_us > slack_us) {
+                lcd_delay_us(exec_us);
+            }
+            break;
+#if LCD_BACKEND != LCD_BACKEND_PIO
+        case LCD_TIMING_BUSY:
+            if (exec_us > slack_us) {
+                // A missing R/W line reads back as busy, give up after 2x
+                absolute_time_t deadline = make_timeout_time_us(2 * exec_us);
+                while (lcd_read_busy() && !time_reached(deadline)) {
+                    tight_loop_contents();
+                }
+            }
+            break;
+#endif
+    }
+}
+#endif
+
 /* Quick helper function for single byte transfers */
 void i2c_write_byte(uint8_t val) {
-    i2c_write_blocking(_I2C_NUM, lcd_addr, &val, 1, false);
+    i2c_dev_write_blocking(lcd_display->dev, &val, 1);
 }
 
 void lcd_toggle_enable(uint8_t val) {
@@ -111,6 +365,13 @@ void lcd_toggle_enable(uint8_t val) {
     sleep_ms(TOGGLE_DELAY_MS);
 }
 
+#if LCD_BATCH_WRITES || LCD_BACKEND != LCD_BACKEND_I2C
+// Both nibbles and their enable strobes go out in one transfer
+void lcd_send_byte(uint8_t val, int mode) {
+    lcd_backend_write(&val, 1, mode);
+    lcd_wait_ready(val, mode);
+}
+#else
 // The display is sent a byte as two separate nibble transfers
 void lcd_send_byte(uint8_t val, int mode) {
     uint8_t high = mode | (val & 0xF0) | LCD_BACKLIGHT;
@@ -121,14 +382,16 @@ void lcd_send_byte(uint8_t val, int mode) {
     i2c_write_byte(low);
     lcd_toggle_enable(low);
 }
+#endif
 
 void lcd_clear(void) {
     lcd_send_byte(LCD_CLEARDISPLAY, LCD_COMMAND);
 }
 
-// go to location on LCD
+// go to location on LCD, lines 2 and 3 of 4 line displays continue lines 0 and 1
 void lcd_set_cursor(int line, int position) {
-    int val = (line == 0) ? 0x80 + position : 0xC0 + position;
+    static const int line_offsets[] = { 0x00, 0x40, MAX_CHARS, 0x40 + MAX_CHARS };
+    int val = LCD_SETDDRAMADDR | (line_offsets[line & 3] + position);
     lcd_send_byte(val, LCD_COMMAND);
 }
 
@@ -136,11 +399,104 @@ void inline lcd_char(char val) {
     lcd_send_byte(val, LCD_CHARACTER);
 }
 
-void lcd_string(const char *s) {
-    while (*s) {
+#if LCD_BATCH_WRITES || LCD_BACKEND != LCD_BACKEND_I2C
+// Characters go out as one transfer per LCD_BATCH_MAX_CHARS
+void lcd_write(const char *s, size_t len) {
+    while (len) {
+        size_t n = MIN(len, LCD_BATCH_MAX_CHARS);
+
+        lcd_backend_write((const uint8_t *) s, n, LCD_CHARACTER);
+        s += n;
+        len -= n;
+    }
+}
+#else
+void lcd_write(const char *s, size_t len) {
+    while (len--) {
         lcd_char(*s++);
     }
 }
+#endif
+
+void lcd_string(const char *s) {
+    lcd_write(s, strlen(s));
+}
+
+#if LCD_BACKEND == LCD_BACKEND_I2C
+// Leaves the cursor wherever the screen's last line ended
+void lcd_show_screen(const lcd_screen_t *screen) {
+    lcd_transmit(screen->bytes, screen->len);
+}
+#else
+// The streams are expander bytes, other backends write the text instead
+void lcd_show_screen(const lcd_screen_t *screen) {
+    for (int line = 0; line < MAX_LINES; line++) {
+        lcd_set_cursor(line, 0);
+        lcd_write(screen->lines[line], MAX_CHARS);
+    }
+}
+#endif
+
+#if LCD_BACKEND != LCD_BACKEND_PIO
+// Expander pins read back what was written while R/W is low and E stays
+// low, so the patterns only toggle the data lines and RS. The OLED has
+// nothing to read back and only has to ACK.
+static void lcd_negotiate_speed(void) {
+#if LCD_BACKEND == LCD_BACKEND_OLED
+    uint baudrate = i2c_dev_negotiate(&lcd_dev, LCD_OLED_MAX_BAUD, NULL, 0);
+#else
+    static const uint8_t pattern[] = {
+        LCD_BACKLIGHT | 0xA0 | LCD_CHARACTER,
+        LCD_BACKLIGHT | 0x50,
+        LCD_BACKLIGHT,
+    };
+    uint baudrate = i2c_dev_negotiate(&lcd_dev, LCD_I2C_MAX_BAUD, pattern, sizeof(pattern));
+#endif
+
+    lcd_speed_khz = (baudrate ? baudrate : i2c_dev_baudrate(&lcd_dev)) / 1000;
+}
+#endif
+
+#if LCD_TIMING_BENCHMARK
+// Reports lcd_init() time and line write throughput for each timing mode
+static int64_t bench_init_us[LCD_TIMING_BUSY + 1];
+static int64_t bench_chars_per_s[LCD_TIMING_BUSY + 1];
+
+// Runs before USB enumerates, the heartbeat prints the results later
+static void lcd_timing_benchmark(void) {
+    static const char line[MAX_CHARS + 1] = "0123456789abcdef";
+    lcd_timing_t timing = lcd_display->timing;
+
+    for (int t = LCD_TIMING_FIXED; t <= LCD_TIMING_BUSY; t++) {
+        lcd_set_timing(t);
+
+        absolute_time_t start = get_absolute_time();
+        lcd_init();
+        int64_t init_us = absolute_time_diff_us(start, get_absolute_time());
+
+        start = get_absolute_time();
+        for (int i = 0; i < LCD_BENCH_LINES; i++) {
+            lcd_set_cursor(i % MAX_LINES, 0);
+            lcd_string(line);
+        }
+        int64_t write_us = absolute_time_diff_us(start, get_absolute_time());
+
+        bench_init_us[t] = init_us;
+        bench_chars_per_s[t] = (int64_t) LCD_BENCH_LINES * MAX_CHARS * 1000000 / write_us;
+    }
+
+    lcd_set_timing(timing);
+}
+
+static void lcd_timing_benchmark_print(void) {
+    static const char *names[] = { "fixed", "table", "busy" };
+
+    for (int t = LCD_TIMING_FIXED; t <= LCD_TIMING_BUSY; t++) {
+        printf("lcd timing %s: init %lld us, %lld chars/s\n", names[t], bench_init_us[t],
+               bench_chars_per_s[t]);
+    }
+}
+#endif
 
 /* Initialization functions */
 void hardware_init(void)
@@ -149,11 +505,31 @@ void hardware_init(void)
     gpio_init(PICO_DEFAULT_LED_PIN);
     gpio_set_dir(PICO_DEFAULT_LED_PIN, GPIO_OUT);
 
-    i2c_init(_I2C_NUM, 100 * 1000);
-    gpio_set_function(_I2C_SDA_PIN, GPIO_FUNC_I2C);
-    gpio_set_function(_I2C_SCL_PIN, GPIO_FUNC_I2C);
-    gpio_pull_up(_I2C_SDA_PIN);
-    gpio_pull_up(_I2C_SCL_PIN);
+    // LCDs and sensors share the bus, each gets a device handle
+    i2c_bus_init(&lcd_bus, _I2C_NUM, I2C_BAUD_DEFAULT, _I2C_SDA_PIN, _I2C_SCL_PIN,
+                 I2C_RISE_NS, 3);
+#if LCD_BACKEND == LCD_BACKEND_OLED
+    i2c_dev_init(&lcd_dev, &lcd_bus, LCD_OLED_ADDR, I2C_BUS_PRIO_LOW);
+    lcd_negotiate_speed();
+    lcd_oled_init(&lcd_dev);
+#else
+    i2c_dev_init(&lcd_dev, &lcd_bus, LCD_I2C_ADDR, I2C_BUS_PRIO_LOW);
+#endif
+#if LCD_BACKEND == LCD_BACKEND_PIO
+    lcd_pio_init(pio0, LCD_PIO_DATA_PIN, LCD_PIO_E_PIN);
+#elif LCD_BACKEND == LCD_BACKEND_I2C
+    lcd_negotiate_speed();
+#endif
 
+#if LCD_TIMING_BENCHMARK
+    lcd_timing_benchmark();
+#endif
     lcd_init();
+    lcd_glyph_reset();
+
+#if LCD_DEMO_LEVEL_METER
+    adc_init();
+    adc_gpio_init(LCD_METER_ADC_PIN);
+    adc_select_input(LCD_METER_ADC_INPUT);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,98 @@
+/**
+ * @brief Hardware-scrolled marquee for the HD44780 LCD
+ *
+ * The line is loaded into its 40 DDRAM columns once, then every step is a
+ * single display shift command. Text that fits in DDRAM just wraps around
+ * it. Longer text is streamed in, a step then also rewrites the one column
+ * coming into view if it holds the wrong character.
+ *
+ * The display shift moves every line, so the marquee owns the display from
+ * lcd_marquee_load() until lcd_marquee_stop().
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include <string.h>
+
+#include "lcd.h"
+#include "lcd_marquee.h"
+
+/* Code */
+// Sets up the stream only, nothing is sent until lcd_marquee_load()
+void lcd_marquee_init(lcd_marquee_t *m, int line, const char *text, int dir) {
+    m->text = text;
+    m->text_len = strlen(text);
+    m->period = m->text_len <= LCD_DDRAM_COLS
+        ? LCD_DDRAM_COLS : m->text_len + LCD_MARQUEE_GAP;
+    m->line = line & 1;
+    m->dir = dir < 0 ? -1 : 1;
+    m->window = 0;
+    m->pos = 0;
+    memset(m->cols, 0xff, sizeof(m->cols));
+    m->steps = 0;
+    m->patches = 0;
+}
+
+static char lcd_marquee_char(lcd_marquee_t *m, int index) {
+    return index < m->text_len ? m->text[index] : ' ';
+}
+
+static int lcd_marquee_addr(lcd_marquee_t *m, int col) {
+    return (m->line ? 0x40 : 0x00) + col;
+}
+
+// Clearing also undoes any display shift, the window starts at column 0
+void lcd_marquee_load(lcd_marquee_t *m) {
+    char buf[LCD_DDRAM_COLS];
+
+    for (int col = 0; col < LCD_DDRAM_COLS; col++) {
+        buf[col] = lcd_marquee_char(m, col);
+        m->cols[col] = col;
+    }
+    m->window = 0;
+    m->pos = 0;
+    m->steps = 0;
+    m->patches = 0;
+
+    lcd_clear();
+    lcd_send_byte(LCD_SETDDRAMADDR | lcd_marquee_addr(m, 0), LCD_COMMAND);
+    lcd_write(buf, LCD_DDRAM_COLS);
+}
+
+void lcd_marquee_step(lcd_marquee_t *m) {
+    int col, index;
+
+    if (m->dir > 0) {
+        m->window = (m->window + 1) % LCD_DDRAM_COLS;
+        m->pos = (m->pos + 1) % m->period;
+        col = (m->window + MAX_CHARS - 1) % LCD_DDRAM_COLS;
+        index = (m->pos + MAX_CHARS - 1) % m->period;
+    } else {
+        m->window = (m->window + LCD_DDRAM_COLS - 1) % LCD_DDRAM_COLS;
+        m->pos = (m->pos + m->period - 1) % m->period;
+        col = m->window;
+        index = m->pos;
+    }
+
+    // Patch the entering column before the shift makes it visible
+    if (m->cols[col] != index) {
+        lcd_send_byte(LCD_SETDDRAMADDR | lcd_marquee_addr(m, col), LCD_COMMAND);
+        lcd_send_byte(lcd_marquee_char(m, index), LCD_CHARACTER);
+        m->cols[col] = index;
+        m->patches++;
+    }
+
+    lcd_send_byte(LCD_CURSORSHIFT | LCD_DISPLAYMOVE
+                  | (m->dir > 0 ? LCD_MOVELEFT : LCD_MOVERIGHT), LCD_COMMAND);
+    m->steps++;
+}
+
+// Return home puts the shift back, DDRAM keeps the marquee text
+void lcd_marquee_stop(lcd_marquee_t *m) {
+    lcd_send_byte(LCD_RETURNHOME, LCD_COMMAND);
+    m->window = 0;
+    memset(m->cols, 0xff, sizeof(m->cols));
+}
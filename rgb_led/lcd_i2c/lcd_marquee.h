@@ -0,0 +1,35 @@
+/**
+ * @brief Hardware-scrolled marquee for the HD44780 LCD
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "constants.h"
+
+typedef struct {
+    const char *text;
+    int text_len;
+    int period;     // Stream length, text plus LCD_MARQUEE_GAP when it is longer than DDRAM
+    int line;
+    int dir;        // 1 scrolls the text left, -1 right
+
+    int window;     // DDRAM column at the left edge of the glass
+    int pos;        // Stream index at the left edge of the glass
+
+    // Stream index held by each DDRAM column, -1 when unknown
+    int16_t cols[LCD_DDRAM_COLS];
+
+    // Traffic counters, cumulative since lcd_marquee_load()
+    uint32_t steps;
+    uint32_t patches;
+} lcd_marquee_t;
+
+void lcd_marquee_init(lcd_marquee_t *m, int line, const char *text, int dir);
+void lcd_marquee_load(lcd_marquee_t *m);
+void lcd_marquee_step(lcd_marquee_t *m);
+void lcd_marquee_stop(lcd_marquee_t *m);
@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2022 Alex Gavin
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+"""Compile a table of LCD screens into PCF8574 expander byte streams.
+
+Each screen becomes a flash-resident array holding, for every row, the
+set-DDRAM-address command followed by the centered, space padded text.
+Showing a screen at runtime is then a single I2C transmit. The encoding
+must match lcd_encode_byte() in lcd_encode.c.
+"""
+
+import argparse
+import sys
+
+# Expander bits, see constants.h
+LCD_CHARACTER = 0x01
+LCD_COMMAND = 0x00
+LCD_ENABLE_BIT = 0x04
+LCD_BACKLIGHT = 0x08
+LCD_SETDDRAMADDR = 0x80
+
+
+def encode_byte(val, mode):
+    out = []
+    for nibble in (val & 0xF0, (val << 4) & 0xF0):
+        data = mode | nibble | LCD_BACKLIGHT
+        out += [data, data | LCD_ENABLE_BIT, data & ~LCD_ENABLE_BIT]
+    return out
+
+
+def line_offset(row, cols):
+    return (0x00, 0x40, cols, 0x40 + cols)[row]
+
+
+def parse_screens(path, rows, cols):
+    screens = []
+    current = []
+    with open(path, encoding="ascii") as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.rstrip("\n")
+            if line.startswith("#"):
+                continue
+            if not line.strip():
+                if current:
+                    screens.append(current)
+                    current = []
+                continue
+            if len(line) > cols:
+                sys.exit(f"{path}:{lineno}: line longer than {cols} columns")
+            current.append(line.strip())
+            if len(current) > rows:
+                sys.exit(f"{path}:{lineno}: screen has more than {rows} rows")
+    if current:
+        screens.append(current)
+    return [s + [""] * (rows - len(s)) for s in screens]
+
+
+def center(text, cols):
+    # Same centering task_print_msg() used to do at runtime
+    start = cols // 2 - len(text) // 2
+    return (" " * start + text).ljust(cols)
+
+
+def encode_screen(lines, cols):
+    out = []
+    for row, text in enumerate(lines):
+        out += encode_byte(LCD_SETDDRAMADDR | line_offset(row, cols), LCD_COMMAND)
+        for c in center(text, cols):
+            out += encode_byte(ord(c), LCD_CHARACTER)
+    return out
+
+
+def c_string(text):
+    return '"' + text.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--rows", type=int, default=2)
+    parser.add_argument("--cols", type=int, default=16)
+    parser.add_argument("input")
+    parser.add_argument("output")
+    args = parser.parse_args()
+
+    screens = parse_screens(args.input, args.rows, args.cols)
+    if not screens:
+        sys.exit(f"{args.input}: no screens")
+
+    out = [
+        f"// Generated by lcd_msgc.py from {args.input.split('/')[-1]}, do not edit",
+        "#pragma once",
+        "",
+        f"#if MAX_LINES != {args.rows} || MAX_CHARS != {args.cols}",
+        f'#error "lcd_messages.h was generated for a {args.rows}x{args.cols} display"',
+        "#endif",
+        "",
+        f"#define LCD_SCREEN_COUNT    {len(screens)}",
+        "",
+    ]
+    for i, lines in enumerate(screens):
+        data = encode_screen(lines, args.cols)
+        out.append(f"static const uint8_t lcd_screen_{i}_bytes[{len(data)}] = {{")
+        for j in range(0, len(data), 12):
+            out.append("    " + " ".join(f"0x{b:02x}," for b in data[j:j + 12]))
+        out.append("};")
+        out.append("")
+
+    out.append("static const lcd_screen_t lcd_screens[LCD_SCREEN_COUNT] = {")
+    for i, lines in enumerate(screens):
+        out.append("    {")
+        out.append("        .lines = { " + ", ".join(c_string(center(l, args.cols)) for l in lines) + " },")
+        out.append(f"        .bytes = lcd_screen_{i}_bytes,")
+        out.append(f"        .len = sizeof(lcd_screen_{i}_bytes),")
+        out.append("    },")
+    out.append("};")
+
+    with open(args.output, "w", encoding="ascii") as f:
+        f.write("\n".join(out) + "\n")
+
+
+if __name__ == "__main__":
+    main()
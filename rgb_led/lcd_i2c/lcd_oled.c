@@ -0,0 +1,162 @@
+/**
+ * @brief SSD1306 OLED backend emulating the HD44780
+ *
+ * Bytes meant for the LCD are run against a model of its DDRAM, CGRAM and
+ * display shift, and the visible cells are redrawn into the OLED
+ * framebuffer. Only the columns that actually changed go out, by DMA
+ * through the I2C bus manager, so everything above lcd_send_byte(), custom
+ * glyphs and the marquee included, works unchanged.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include <string.h>
+
+#include "pico/stdlib.h"
+
+#include "constants.h"
+#include "lcd_oled.h"
+
+/* Globals */
+oled_fb_t lcd_oled_fb;
+
+static i2c_dev_t *lcd_oled_dev;
+
+// HD44780 state, addr is the DDRAM or CGRAM address counter
+static uint8_t lcd_oled_ddram[2][LCD_DDRAM_COLS];
+static uint8_t lcd_oled_cgram[64];
+static uint8_t lcd_oled_addr;
+static bool lcd_oled_cgram_mode;
+static int lcd_oled_shift;
+
+// 128x64, charge pump on, horizontal addressing, column 0 at the left
+static const uint8_t lcd_oled_init_cmds[] = {
+    OLED_CTRL_CMD,
+    0xAE, 0xD5, 0x80, 0xA8, 0x3F, 0xD3, 0x00, 0x40, 0x8D, 0x14, 0x20, 0x00,
+    0xA1, 0xC8, 0xDA, 0x12, 0x81, 0xCF, 0xD9, 0xF1, 0xDB, 0x40, 0xA4, 0xA6,
+    0xAF,
+};
+
+/* Code */
+static void lcd_oled_send(void *ctx, const uint8_t *buf, size_t len) {
+    i2c_dev_write_blocking(lcd_oled_dev, buf, len);
+}
+
+// Codes 0x00-0x0F are CGRAM, 0xFF is the solid block of the A00 ROM
+static uint8_t lcd_oled_column(uint8_t code, int col) {
+    if (code < 0x10) {
+        const uint8_t *rows = &lcd_oled_cgram[(code & 7) * 8];
+        uint8_t bits = 0;
+
+        for (int y = 0; y < 8; y++) {
+            bits |= ((rows[y] >> (4 - col)) & 1) << y;
+        }
+        return bits;
+    }
+    if (code == 0xFF) {
+        return 0x7F;
+    }
+
+    const uint8_t *glyph = oled_font_glyph(code);
+    return glyph ? glyph[col] : 0;
+}
+
+// Cheap to run in full, cells that did not change leave the framebuffer clean
+static void lcd_oled_render(void) {
+    for (int line = 0; line < MAX_LINES; line++) {
+        int page = LCD_OLED_FIRST_PAGE + line * LCD_OLED_LINE_PAGES;
+
+        for (int cell = 0; cell < MAX_CHARS; cell++) {
+            uint8_t code = lcd_oled_ddram[line][(cell + lcd_oled_shift) % LCD_DDRAM_COLS];
+            int x = cell * LCD_OLED_CELL_WIDTH;
+
+            for (int col = 0; col < LCD_OLED_CELL_WIDTH; col++) {
+                bool glyph_col = col >= 1 && col <= 5;
+
+                oled_fb_put(&lcd_oled_fb, page, x + col,
+                            glyph_col ? lcd_oled_column(code, col - 1) : 0);
+            }
+        }
+    }
+}
+
+// Decoded by highest set bit like the controller does
+static void lcd_oled_command(uint8_t val) {
+    if (val & LCD_SETDDRAMADDR) {
+        lcd_oled_addr = val & 0x7F;
+        lcd_oled_cgram_mode = false;
+    } else if (val & LCD_SETCGRAMADDR) {
+        lcd_oled_addr = val & 0x3F;
+        lcd_oled_cgram_mode = true;
+    } else if (val & LCD_FUNCTIONSET) {
+        // Nothing to model
+    } else if (val & LCD_CURSORSHIFT) {
+        int step = (val & LCD_MOVERIGHT) ? -1 : 1;
+
+        if (val & LCD_DISPLAYMOVE) {
+            lcd_oled_shift = (lcd_oled_shift + LCD_DDRAM_COLS + step) % LCD_DDRAM_COLS;
+        } else {
+            lcd_oled_addr -= step;
+        }
+    } else if (val & (LCD_DISPLAYCONTROL | LCD_ENTRYMODESET)) {
+        // Nothing to model
+    } else if (val) {
+        // Return home keeps DDRAM, clear blanks it as well
+        if (val == LCD_CLEARDISPLAY) {
+            memset(lcd_oled_ddram, ' ', sizeof(lcd_oled_ddram));
+        }
+        lcd_oled_addr = 0;
+        lcd_oled_cgram_mode = false;
+        lcd_oled_shift = 0;
+    }
+}
+
+static void lcd_oled_data(uint8_t val) {
+    if (lcd_oled_cgram_mode) {
+        lcd_oled_cgram[lcd_oled_addr] = val & 0x1F;
+        lcd_oled_addr = (lcd_oled_addr + 1) & 0x3F;
+        return;
+    }
+
+    // Line 0 runs on into line 1 and line 1 wraps back to line 0
+    int line = lcd_oled_addr >= 0x40;
+    int col = (lcd_oled_addr & 0x3F) % LCD_DDRAM_COLS;
+
+    lcd_oled_ddram[line][col] = val;
+    if (++col == LCD_DDRAM_COLS) {
+        col = 0;
+        line ^= 1;
+    }
+    lcd_oled_addr = (line ? 0x40 : 0x00) + col;
+}
+
+void lcd_oled_write(const uint8_t *bytes, size_t n, int mode) {
+    for (size_t i = 0; i < n; i++) {
+        if (mode == LCD_COMMAND) {
+            lcd_oled_command(bytes[i]);
+        } else {
+            lcd_oled_data(bytes[i]);
+        }
+    }
+    lcd_oled_render();
+    oled_fb_flush(&lcd_oled_fb, lcd_oled_send, NULL);
+}
+
+/* Initialization functions */
+// The first flush clears the whole panel, after that only changes are sent
+void lcd_oled_init(i2c_dev_t *dev) {
+    lcd_oled_dev = dev;
+    memset(lcd_oled_ddram, ' ', sizeof(lcd_oled_ddram));
+    memset(lcd_oled_cgram, 0, sizeof(lcd_oled_cgram));
+    lcd_oled_addr = 0;
+    lcd_oled_cgram_mode = false;
+    lcd_oled_shift = 0;
+
+    i2c_dev_write_blocking(dev, lcd_oled_init_cmds, sizeof(lcd_oled_init_cmds));
+    oled_fb_init(&lcd_oled_fb);
+    lcd_oled_render();
+    oled_fb_flush(&lcd_oled_fb, lcd_oled_send, NULL);
+}
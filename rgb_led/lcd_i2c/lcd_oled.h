@@ -0,0 +1,19 @@
+/**
+ * @brief SSD1306 OLED backend emulating the HD44780
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "i2c_bus.h"
+#include "oled_fb.h"
+
+extern oled_fb_t lcd_oled_fb;
+
+void lcd_oled_init(i2c_dev_t *dev);
+void lcd_oled_write(const uint8_t *bytes, size_t n, int mode);
@@ -0,0 +1,70 @@
+/**
+ * @brief PIO driven 4-bit parallel HD44780 backend
+ *
+ * Bytes are packed one per 16-bit FIFO entry and fed to the state machine
+ * by DMA. The PIO program generates the E strobes, setup/hold times and
+ * the per-instruction execution wait, see lcd_4bit.pio.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "pico/stdlib.h"
+#include "hardware/dma.h"
+
+#include "constants.h"
+#include "lcd_pio.h"
+#include "lcd_4bit.pio.h"
+
+/* Globals */
+static PIO lcd_pio;
+static uint lcd_pio_sm;
+static int lcd_pio_dma_chan;
+static uint16_t lcd_pio_buf[LCD_BATCH_MAX_CHARS];
+
+/* Code */
+void lcd_pio_init(PIO pio, uint data_pin, uint e_pin) {
+    lcd_pio = pio;
+    lcd_pio_sm = pio_claim_unused_sm(pio, true);
+
+    uint offset = pio_add_program(pio, &lcd_4bit_program);
+    lcd_4bit_program_init(pio, lcd_pio_sm, offset, data_pin, e_pin);
+
+    lcd_pio_dma_chan = dma_claim_unused_channel(true);
+    dma_channel_config c = dma_channel_get_default_config(lcd_pio_dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(pio, lcd_pio_sm, true));
+    dma_channel_configure(lcd_pio_dma_chan, &c, &pio->txf[lcd_pio_sm], NULL, 0, false);
+}
+
+// Returns once the state machine has clocked out the last byte and waited
+// its execution time, so the caller's timing engine can take over
+void lcd_pio_write(const uint8_t *bytes, size_t n, int mode) {
+    uint32_t stall = 1u << (PIO_FDEBUG_TXSTALL_LSB + lcd_pio_sm);
+
+    while (n) {
+        size_t chunk = MIN(n, count_of(lcd_pio_buf));
+
+        for (size_t i = 0; i < chunk; i++) {
+            uint8_t rs = mode ? 0x10 : 0x00;
+            lcd_pio_buf[i] = (rs | (bytes[i] >> 4)) | ((rs | (bytes[i] & 0x0F)) << 8);
+        }
+
+        dma_channel_transfer_from_buffer_now(lcd_pio_dma_chan, lcd_pio_buf, chunk);
+        dma_channel_wait_for_finish_blocking(lcd_pio_dma_chan);
+
+        // Each byte takes ~45 us to clock out, so the machine is still busy
+        // with the tail of the FIFO when the stall flag is cleared here
+        lcd_pio->fdebug = stall;
+        while (!(lcd_pio->fdebug & stall)) {
+            tight_loop_contents();
+        }
+
+        bytes += chunk;
+        n -= chunk;
+    }
+}
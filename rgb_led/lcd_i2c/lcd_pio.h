@@ -0,0 +1,16 @@
+/**
+ * @brief PIO driven 4-bit parallel HD44780 backend
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hardware/pio.h"
+
+void lcd_pio_init(PIO pio, uint data_pin, uint e_pin);
+void lcd_pio_write(const uint8_t *bytes, size_t n, int mode);
@@ -0,0 +1,44 @@
+/**
+ * @brief HD44780 command execution times
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "constants.h"
+#include "lcd_timing.h"
+
+/* Globals */
+// HD44780U datasheet table 6 at fosc = 270 kHz, indexed by the highest set
+// bit of the instruction, which is what selects the instruction
+static const uint16_t lcd_cmd_exec_us[8] = {
+    1520,   // LCD_CLEARDISPLAY
+    1520,   // LCD_RETURNHOME
+    37,     // LCD_ENTRYMODESET
+    37,     // LCD_DISPLAYCONTROL
+    37,     // LCD_CURSORSHIFT
+    37,     // LCD_FUNCTIONSET
+    37,     // LCD_SETCGRAMADDR
+    37,     // LCD_SETDDRAMADDR
+};
+
+// Data writes take an extra 4 us for the address counter update
+#define LCD_DATA_EXEC_US    (37 + 4)
+
+/* Code */
+uint32_t lcd_exec_time_us(uint8_t val, int mode) {
+    uint32_t us;
+
+    if (mode == LCD_CHARACTER) {
+        us = LCD_DATA_EXEC_US;
+    } else if (val == 0) {
+        return 0;
+    } else {
+        us = lcd_cmd_exec_us[31 - __builtin_clz(val)];
+    }
+
+    // Execution time scales with the oscillator, which drifts low at 3.3 V
+    return us * (100 + LCD_TIMING_MARGIN_PCT) / 100;
+}
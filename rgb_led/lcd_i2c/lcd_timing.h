@@ -0,0 +1,12 @@
+/**
+ * @brief HD44780 command execution times
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdint.h>
+
+uint32_t lcd_exec_time_us(uint8_t val, int mode);
@@ -0,0 +1,88 @@
+/**
+ * @brief LCD bar graph and level meter widgets
+ *
+ * Both draw into a framebuffer with one pixel column (bar) or row (meter)
+ * of resolution, using CGRAM glyphs for the partially filled cell. The bar
+ * needs 4 glyphs and the meter 7, so each fits the glyph cache on its own
+ * and steady state frames upload nothing.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include "lcd_glyph.h"
+#include "lcd_widget.h"
+
+/* Defines */
+#define LCD_CELL_WIDTH      5
+#define LCD_CELL_HEIGHT     8
+
+// ROM character 0xFF is a solid block on A00 character sets
+#define LCD_CHAR_FULL       ((char) 0xFF)
+#define LCD_CHAR_EMPTY      ' '
+
+/* Globals */
+// Leftmost n pixel columns lit
+static const lcd_glyph_t lcd_bar_glyphs[LCD_CELL_WIDTH - 1] = {
+    {{ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10 }},
+    {{ 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18 }},
+    {{ 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C }},
+    {{ 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E }},
+};
+
+// Bottom n pixel rows lit
+static const lcd_glyph_t lcd_meter_glyphs[LCD_CELL_HEIGHT - 1] = {
+    {{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F }},
+    {{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F }},
+    {{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F }},
+    {{ 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F }},
+    {{ 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F }},
+    {{ 0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F }},
+    {{ 0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F }},
+};
+
+/* Code */
+static uint32_t lcd_widget_scale(uint32_t value, uint32_t max, uint32_t steps) {
+    if (max == 0 || value >= max) {
+        return steps;
+    }
+    return (uint64_t) value * steps / max;
+}
+
+// Horizontal bar, width cells from (row, col) rightwards
+void lcd_bar_draw(lcd_fb_t *fb, int row, int col, int width, uint32_t value, uint32_t max) {
+    uint32_t lit = lcd_widget_scale(value, max, width * LCD_CELL_WIDTH);
+
+    for (int cell = 0; cell < width; cell++, lit -= MIN(lit, LCD_CELL_WIDTH)) {
+        char c;
+
+        if (lit >= LCD_CELL_WIDTH) {
+            c = LCD_CHAR_FULL;
+        } else if (lit == 0) {
+            c = LCD_CHAR_EMPTY;
+        } else {
+            c = lcd_glyph_get(&lcd_bar_glyphs[lit - 1]);
+        }
+        lcd_fb_put(fb, row, col + cell, c);
+    }
+}
+
+// Vertical meter, height cells from (row, col) upwards
+void lcd_meter_draw(lcd_fb_t *fb, int row, int col, int height, uint32_t value, uint32_t max) {
+    uint32_t lit = lcd_widget_scale(value, max, height * LCD_CELL_HEIGHT);
+
+    for (int cell = 0; cell < height; cell++, lit -= MIN(lit, LCD_CELL_HEIGHT)) {
+        char c;
+
+        if (lit >= LCD_CELL_HEIGHT) {
+            c = LCD_CHAR_FULL;
+        } else if (lit == 0) {
+            c = LCD_CHAR_EMPTY;
+        } else {
+            c = lcd_glyph_get(&lcd_meter_glyphs[lit - 1]);
+        }
+        lcd_fb_put(fb, row - cell, col, c);
+    }
+}
@@ -0,0 +1,15 @@
+/**
+ * @brief LCD bar graph and level meter widgets
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stdint.h>
+
+#include "lcd_fb.h"
+
+void lcd_bar_draw(lcd_fb_t *fb, int row, int col, int width, uint32_t value, uint32_t max);
+void lcd_meter_draw(lcd_fb_t *fb, int row, int col, int height, uint32_t value, uint32_t max);
@@ -0,0 +1,221 @@
+/**
+ * @brief 1 bpp framebuffer for SSD1306-class 128x64 OLEDs
+ *
+ * Drawing goes into a RAM copy of GDDRAM and only bytes that change are
+ * marked dirty. A flush sends each dirty span as a column/page address
+ * window followed by its data, with neighbouring pages sharing a window
+ * when that costs less than setting up another. Nothing here touches the
+ * hardware, the transport is a callback, so it also runs on the host.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Includes */
+#include <string.h>
+
+#include "oled_fb.h"
+
+/* Globals */
+// Classic 5x7 font for 0x20-0x7E, one byte per column, bit 0 at the top
+static const uint8_t oled_font[][5] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00 }, { 0x00, 0x00, 0x5F, 0x00, 0x00 },   // ' ' !
+    { 0x00, 0x07, 0x00, 0x07, 0x00 }, { 0x14, 0x7F, 0x14, 0x7F, 0x14 },   // " #
+    { 0x24, 0x2A, 0x7F, 0x2A, 0x12 }, { 0x23, 0x13, 0x08, 0x64, 0x62 },   // $ %
+    { 0x36, 0x49, 0x55, 0x22, 0x50 }, { 0x00, 0x05, 0x03, 0x00, 0x00 },   // & '
+    { 0x00, 0x1C, 0x22, 0x41, 0x00 }, { 0x00, 0x41, 0x22, 0x1C, 0x00 },   // ( )
+    { 0x08, 0x2A, 0x1C, 0x2A, 0x08 }, { 0x08, 0x08, 0x3E, 0x08, 0x08 },   // * +
+    { 0x00, 0x50, 0x30, 0x00, 0x00 }, { 0x08, 0x08, 0x08, 0x08, 0x08 },   // , -
+    { 0x00, 0x60, 0x60, 0x00, 0x00 }, { 0x20, 0x10, 0x08, 0x04, 0x02 },   // . /
+    { 0x3E, 0x51, 0x49, 0x45, 0x3E }, { 0x00, 0x42, 0x7F, 0x40, 0x00 },   // 0 1
+    { 0x42, 0x61, 0x51, 0x49, 0x46 }, { 0x21, 0x41, 0x45, 0x4B, 0x31 },   // 2 3
+    { 0x18, 0x14, 0x12, 0x7F, 0x10 }, { 0x27, 0x45, 0x45, 0x45, 0x39 },   // 4 5
+    { 0x3C, 0x4A, 0x49, 0x49, 0x30 }, { 0x01, 0x71, 0x09, 0x05, 0x03 },   // 6 7
+    { 0x36, 0x49, 0x49, 0x49, 0x36 }, { 0x06, 0x49, 0x49, 0x29, 0x1E },   // 8 9
+    { 0x00, 0x36, 0x36, 0x00, 0x00 }, { 0x00, 0x56, 0x36, 0x00, 0x00 },   // : ;
+    { 0x08, 0x14, 0x22, 0x41, 0x00 }, { 0x14, 0x14, 0x14, 0x14, 0x14 },   // < =
+    { 0x00, 0x41, 0x22, 0x14, 0x08 }, { 0x02, 0x01, 0x51, 0x09, 0x06 },   // > ?
+    { 0x32, 0x49, 0x79, 0x41, 0x3E }, { 0x7E, 0x11, 0x11, 0x11, 0x7E },   // @ A
+    { 0x7F, 0x49, 0x49, 0x49, 0x36 }, { 0x3E, 0x41, 0x41, 0x41, 0x22 },   // B C
+    { 0x7F, 0x41, 0x41, 0x22, 0x1C }, { 0x7F, 0x49, 0x49, 0x49, 0x41 },   // D E
+    { 0x7F, 0x09, 0x09, 0x01, 0x01 }, { 0x3E, 0x41, 0x41, 0x51, 0x32 },   // F G
+    { 0x7F, 0x08, 0x08, 0x08, 0x7F }, { 0x00, 0x41, 0x7F, 0x41, 0x00 },   // H I
+    { 0x20, 0x40, 0x41, 0x3F, 0x01 }, { 0x7F, 0x08, 0x14, 0x22, 0x41 },   // J K
+    { 0x7F, 0x40, 0x40, 0x40, 0x40 }, { 0x7F, 0x02, 0x04, 0x02, 0x7F },   // L M
+    { 0x7F, 0x04, 0x08, 0x10, 0x7F }, { 0x3E, 0x41, 0x41, 0x41, 0x3E },   // N O
+    { 0x7F, 0x09, 0x09, 0x09, 0x06 }, { 0x3E, 0x41, 0x51, 0x21, 0x5E },   // P Q
+    { 0x7F, 0x09, 0x19, 0x29, 0x46 }, { 0x46, 0x49, 0x49, 0x49, 0x31 },   // R S
+    { 0x01, 0x01, 0x7F, 0x01, 0x01 }, { 0x3F, 0x40, 0x40, 0x40, 0x3F },   // T U
+    { 0x1F, 0x20, 0x40, 0x20, 0x1F }, { 0x7F, 0x20, 0x18, 0x20, 0x7F },   // V W
+    { 0x63, 0x14, 0x08, 0x14, 0x63 }, { 0x03, 0x04, 0x78, 0x04, 0x03 },   // X Y
+    { 0x61, 0x51, 0x49, 0x45, 0x43 }, { 0x00, 0x7F, 0x41, 0x41, 0x00 },   // Z [
+    { 0x02, 0x04, 0x08, 0x10, 0x20 }, { 0x00, 0x41, 0x41, 0x7F, 0x00 },   // \ ]
+    { 0x04, 0x02, 0x01, 0x02, 0x04 }, { 0x40, 0x40, 0x40, 0x40, 0x40 },   // ^ _
+    { 0x00, 0x01, 0x02, 0x04, 0x00 }, { 0x20, 0x54, 0x54, 0x54, 0x78 },   // ` a
+    { 0x7F, 0x48, 0x44, 0x44, 0x38 }, { 0x38, 0x44, 0x44, 0x44, 0x20 },   // b c
+    { 0x38, 0x44, 0x44, 0x48, 0x7F }, { 0x38, 0x54, 0x54, 0x54, 0x18 },   // d e
+    { 0x08, 0x7E, 0x09, 0x01, 0x02 }, { 0x0C, 0x52, 0x52, 0x52, 0x3E },   // f g
+    { 0x7F, 0x08, 0x04, 0x04, 0x78 }, { 0x00, 0x44, 0x7D, 0x40, 0x00 },   // h i
+    { 0x20, 0x40, 0x44, 0x3D, 0x00 }, { 0x7F, 0x10, 0x28, 0x44, 0x00 },   // j k
+    { 0x00, 0x41, 0x7F, 0x40, 0x00 }, { 0x7C, 0x04, 0x18, 0x04, 0x78 },   // l m
+    { 0x7C, 0x08, 0x04, 0x04, 0x78 }, { 0x38, 0x44, 0x44, 0x44, 0x38 },   // n o
+    { 0x7C, 0x14, 0x14, 0x14, 0x08 }, { 0x08, 0x14, 0x14, 0x18, 0x7C },   // p q
+    { 0x7C, 0x08, 0x04, 0x04, 0x08 }, { 0x48, 0x54, 0x54, 0x54, 0x20 },   // r s
+    { 0x04, 0x3F, 0x44, 0x40, 0x20 }, { 0x3C, 0x40, 0x40, 0x20, 0x7C },   // t u
+    { 0x1C, 0x20, 0x40, 0x20, 0x1C }, { 0x3C, 0x40, 0x30, 0x40, 0x3C },   // v w
+    { 0x44, 0x28, 0x10, 0x28, 0x44 }, { 0x0C, 0x50, 0x50, 0x50, 0x3C },   // x y
+    { 0x44, 0x64, 0x54, 0x4C, 0x44 }, { 0x00, 0x08, 0x36, 0x41, 0x00 },   // z {
+    { 0x00, 0x00, 0x7F, 0x00, 0x00 }, { 0x00, 0x41, 0x36, 0x08, 0x00 },   // | }
+    { 0x08, 0x04, 0x08, 0x10, 0x08 },                                     // ~
+};
+
+/* Code */
+static inline int oled_min(int a, int b) {
+    return a < b ? a : b;
+}
+
+static inline int oled_max(int a, int b) {
+    return a > b ? a : b;
+}
+
+// Everything starts dirty, the first flush writes the whole panel
+void oled_fb_init(oled_fb_t *fb) {
+    memset(fb->pages, 0, sizeof(fb->pages));
+    for (int page = 0; page < OLED_PAGES; page++) {
+        fb->dirty_lo[page] = 0;
+        fb->dirty_hi[page] = OLED_WIDTH - 1;
+    }
+    fb->windows = 0;
+    fb->xfers = 0;
+    fb->bytes = 0;
+}
+
+// Writes that do not change the byte leave it clean
+void oled_fb_put(oled_fb_t *fb, int page, int x, uint8_t bits) {
+    if (page < 0 || page >= OLED_PAGES || x < 0 || x >= OLED_WIDTH) {
+        return;
+    }
+    if (fb->pages[page][x] == bits) {
+        return;
+    }
+    fb->pages[page][x] = bits;
+    if (x < fb->dirty_lo[page]) {
+        fb->dirty_lo[page] = x;
+    }
+    if (x > fb->dirty_hi[page]) {
+        fb->dirty_hi[page] = x;
+    }
+}
+
+void oled_fb_fill(oled_fb_t *fb, uint8_t pattern) {
+    for (int page = 0; page < OLED_PAGES; page++) {
+        for (int x = 0; x < OLED_WIDTH; x++) {
+            oled_fb_put(fb, page, x, pattern);
+        }
+    }
+}
+
+void oled_fb_pixel(oled_fb_t *fb, int x, int y, int on) {
+    if (y < 0 || y >= OLED_PAGES * 8 || x < 0 || x >= OLED_WIDTH) {
+        return;
+    }
+    uint8_t mask = 1 << (y & 7);
+    uint8_t bits = fb->pages[y >> 3][x];
+
+    oled_fb_put(fb, y >> 3, x, on ? bits | mask : bits & ~mask);
+}
+
+const uint8_t *oled_font_glyph(char c) {
+    if (c < 0x20 || c > 0x7E) {
+        return NULL;
+    }
+    return oled_font[c - 0x20];
+}
+
+// Draws the glyph and a blank spacing column, returns the advance
+int oled_fb_char(oled_fb_t *fb, int page, int x, char c) {
+    const uint8_t *glyph = oled_font_glyph(c);
+
+    for (int col = 0; col < 5; col++) {
+        oled_fb_put(fb, page, x + col, glyph ? glyph[col] : 0);
+    }
+    oled_fb_put(fb, page, x + 5, 0);
+    return 6;
+}
+
+// Text running off the right edge is clipped
+void oled_fb_text(oled_fb_t *fb, int page, int x, const char *s) {
+    while (*s && x < OLED_WIDTH) {
+        x += oled_fb_char(fb, page, x, *s++);
+    }
+}
+
+static void oled_fb_send_window(oled_fb_t *fb, oled_send_t send, void *ctx,
+                                int first, int last, int lo, int hi) {
+    uint8_t cmds[] = { OLED_CTRL_CMD, 0x21, lo, hi, 0x22, first, last };
+
+    send(ctx, cmds, sizeof(cmds));
+    fb->xfers++;
+    fb->bytes += sizeof(cmds);
+
+    // Horizontal addressing wraps to lo on the next page at the end of hi
+    size_t n = 0;
+    for (int page = first; page <= last; page++) {
+        for (int x = lo; x <= hi; x++) {
+            if (n == 0) {
+                fb->xfer[n++] = OLED_CTRL_DATA;
+            }
+            fb->xfer[n++] = fb->pages[page][x];
+            if (n == OLED_XFER_MAX) {
+                send(ctx, fb->xfer, n);
+                fb->xfers++;
+                fb->bytes += n;
+                n = 0;
+            }
+        }
+        fb->dirty_lo[page] = OLED_WIDTH;
+        fb->dirty_hi[page] = -1;
+    }
+    if (n) {
+        send(ctx, fb->xfer, n);
+        fb->xfers++;
+        fb->bytes += n;
+    }
+    fb->windows++;
+}
+
+void oled_fb_flush(oled_fb_t *fb, oled_send_t send, void *ctx) {
+    int page = 0;
+
+    while (page < OLED_PAGES) {
+        if (fb->dirty_lo[page] > fb->dirty_hi[page]) {
+            page++;
+            continue;
+        }
+
+        // Grow the window down while the extra clean columns cost less
+        // than a window of their own
+        int first = page, last = page;
+        int lo = fb->dirty_lo[page], hi = fb->dirty_hi[page];
+        int dirty = hi - lo + 1;
+
+        while (last + 1 < OLED_PAGES && fb->dirty_lo[last + 1] <= fb->dirty_hi[last + 1]) {
+            int next_lo = oled_min(lo, fb->dirty_lo[last + 1]);
+            int next_hi = oled_max(hi, fb->dirty_hi[last + 1]);
+            int next_dirty = dirty + fb->dirty_hi[last + 1] - fb->dirty_lo[last + 1] + 1;
+            int waste = (next_hi - next_lo + 1) * (last + 2 - first) - next_dirty;
+
+            if (waste > OLED_MERGE_SLACK) {
+                break;
+            }
+            lo = next_lo;
+            hi = next_hi;
+            dirty = next_dirty;
+            last++;
+        }
+
+        oled_fb_send_window(fb, send, ctx, first, last, lo, hi);
+        page = last + 1;
+    }
+}
@@ -0,0 +1,56 @@
+/**
+ * @brief 1 bpp framebuffer for SSD1306-class 128x64 OLEDs
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OLED_WIDTH          128
+#define OLED_PAGES          8
+
+// Longest transaction handed to the transport, I2C_BUS_MAX_XFER on target.
+// Data past it is split, the controller's address pointer carries over.
+#define OLED_XFER_MAX       256
+
+// Clean columns a flush will resend to cover two dirty pages with one
+// window instead of setting up a second one
+#define OLED_MERGE_SLACK    16
+
+// Control bytes leading each I2C transaction
+#define OLED_CTRL_CMD       0x00
+#define OLED_CTRL_DATA      0x40
+
+// One transaction, control byte first
+typedef void (*oled_send_t)(void *ctx, const uint8_t *buf, size_t len);
+
+typedef struct {
+    // GDDRAM layout, bit 0 of each byte is the top pixel of the page
+    uint8_t pages[OLED_PAGES][OLED_WIDTH];
+
+    // Dirty columns per page, lo > hi when the page is clean
+    int16_t dirty_lo[OLED_PAGES];
+    int16_t dirty_hi[OLED_PAGES];
+
+    // Traffic counters, cumulative since oled_fb_init()
+    uint32_t windows;
+    uint32_t xfers;
+    uint32_t bytes;
+
+    uint8_t xfer[OLED_XFER_MAX];
+} oled_fb_t;
+
+void oled_fb_init(oled_fb_t *fb);
+void oled_fb_fill(oled_fb_t *fb, uint8_t pattern);
+void oled_fb_put(oled_fb_t *fb, int page, int x, uint8_t bits);
+void oled_fb_pixel(oled_fb_t *fb, int x, int y, int on);
+int oled_fb_char(oled_fb_t *fb, int page, int x, char c);
+void oled_fb_text(oled_fb_t *fb, int page, int x, const char *s);
+void oled_fb_flush(oled_fb_t *fb, oled_send_t send, void *ctx);
+
+// 5 column bytes for a printable ASCII character, NULL otherwise
+const uint8_t *oled_font_glyph(char c);
@@ -11,12 +11,29 @@
 #define GREEN_PIN       17
 #define BLUE_PIN        18
 #define LED_PIN         25
-#define ADC_GPIO_PIN    26
 
-#define ADC_INPUT       0
+// 0 for the original board: one pot on input 0 (GPIO 26) driving the
+// color SW1 picks. 1 needs two more pots wired to GPIO 27 and 28, one per
+// color, and leaves SW1 unused; without them green and blue follow
+// floating pins.
+#define POT_RGB         0
+
+// With a pot per color this is over all the scanned inputs, the
+// temperature sensor is always one of them, and each input is filtered a
+// block, 256 samples, at a time, 10 ms with three pots. The one pot is
+// captured free running in blocks of about 10 ms.
+#define ADC_SAMPLE_RATE 100000
+#define ADC_INPUT       0   // GPIO 26
+#define ADC_BLOCK_LEN   1024
+#define ADC_BLOCKS      4
 
 #define HEARTBEAT_DELAY 500
-#define SAMPLE_DELAY    100
+
+// NVIC priorities, lower is more urgent. Button edges only take a
+// timestamp and a block interrupt only counts blocks, USB can wait.
+#define DMA_IRQ_PRIORITY    0x80
+#define GPIO_IRQ_PRIORITY   0x80
+#define USB_IRQ_PRIORITY    0xC0
 
 /* Includes */
 #include <stdio.h>
@@ -25,11 +42,14 @@
 #include <task.h>
 
 #include "pico/stdlib.h"
-#include "hardware/adc.h"
 #include "hardware/gpio.h"
 #include "hardware/irq.h"
 #include "hardware/pwm.h"
 
+#include "adc_capture.h"
+#include "adc_scan.h"
+#include "button.h"
+
 /* Globals */
 uint slice_num_red;
 uint slice_num_green;
@@ -38,23 +58,71 @@ uint slice_num_blue;
 uint16_t gpio_pwm_level;
 uint cur_led_pin = RED_PIN;
 
+static volatile int32_t temp_mc;    // On-die temperature, m°C
+
+#if !POT_RGB
+// The DMA wraps its writes on the ring's size
+static uint16_t adc_ring[ADC_BLOCKS * ADC_BLOCK_LEN]
+    __attribute__((aligned(ADC_BLOCKS * ADC_BLOCK_LEN * sizeof(uint16_t))));
+#endif
+
+// Mean of 16 samples, or 64 for the one pot, into a 5 tap median and a
+// light low pass. The LED moves once the pot does by more than 6 of the
+// 4096 ADC steps, and the bottom 30 steps are off.
+static const adc_filter_config_t pot_filter_config = {
+    .decimate_shift = POT_RGB ? 4 : 6,
+    .median_len = 5,
+    .iir_shift = 2,
+    .deadband = 6 << 4,
+    .zero = 30 << 4,
+};
+
+#if POT_RGB
+// A block averaged into each value, smoothed over about a third of a second
+static const adc_filter_config_t temp_filter_config = {
+    .decimate_shift = 8,
+    .iir_shift = 5,
+};
+#endif
+
 /* Prototypes */
-void gpio_int_callback(uint gpio, uint32_t events_unused);
+void button_pressed(uint gpio, button_event_t event, uint64_t time_us);
 void heartbeat(void* unused);
 void change_brightness(void* unused);
+void pot_changed(uint input, uint16_t value, void *pin);
+void temp_changed(uint input, uint16_t value, void *unused);
 void hardware_init(void);
 
 /* Code */
 int main()
 {
+    TaskHandle_t brightness_task;
+
     printf("program start\n");
     stdio_init_all();
-    hardware_init();
+    irq_set_priority(USBCTRL_IRQ, USB_IRQ_PRIORITY);
 
     printf("create tasks\n");
-    xTaskCreate(change_brightness, "CHANGE_BRIGHTNESS_task", 256, NULL, 1, NULL);
+    xTaskCreate(change_brightness, "CHANGE_BRIGHTNESS_task", 256, NULL, 1, &brightness_task);
     xTaskCreate(heartbeat, "LED_Task", 256, NULL, tskIDLE_PRIORITY, NULL);
 
+    // Button presses and pot changes are handled in the brightness task,
+    // so the LED pins and levels are only ever touched from there. Buttons
+    // and ADC blocks share its notification slot, see CMakeLists.txt.
+    button_init(brightness_task, GPIO_IRQ_PRIORITY);
+#if POT_RGB
+    adc_scan_init(brightness_task, 0x7 | 1u << ADC_SCAN_TEMP, ADC_SAMPLE_RATE);
+    adc_scan_bind(0, &pot_filter_config, pot_changed, (void *) RED_PIN);
+    adc_scan_bind(1, &pot_filter_config, pot_changed, (void *) GREEN_PIN);
+    adc_scan_bind(2, &pot_filter_config, pot_changed, (void *) BLUE_PIN);
+    adc_scan_bind(ADC_SCAN_TEMP, &temp_filter_config, temp_changed, NULL);
+#else
+    adc_capture_init(brightness_task, ADC_INPUT, ADC_SAMPLE_RATE, adc_ring,
+                     ADC_BLOCK_LEN, ADC_BLOCKS);
+    irq_set_priority(DMA_IRQ_1, DMA_IRQ_PRIORITY);
+#endif
+    hardware_init();
+
     printf("start scheduler\n");
     vTaskStartScheduler();
 
@@ -66,7 +134,16 @@ int main()
 void heartbeat(void* notUsed)
 {   
     while (true) {
-        printf("hb-tick: %d\n", HEARTBEAT_DELAY);
+        printf("hb-tick: %d, buttons: %lu edges, %lu bounces, worst isr %lu us\n",
+               HEARTBEAT_DELAY, button_stats.edges, button_stats.bounces, button_stats.isr_max_us);
+#if POT_RGB
+        printf("ADC: %lu blocks, %lu overruns, %lu resyncs, %ld.%01ld C\n",
+               adc_scan_stats.blocks, adc_scan_stats.overruns, adc_scan_stats.resyncs,
+               temp_mc / 1000, (temp_mc < 0 ? -temp_mc : temp_mc) % 1000 / 100);
+#else
+        printf("ADC: %lu blocks, %lu overruns\n",
+               adc_capture_stats.blocks, adc_capture_stats.overruns);
+#endif
         gpio_put(PICO_DEFAULT_LED_PIN, 1);
         vTaskDelay(HEARTBEAT_DELAY);
         gpio_put(PICO_DEFAULT_LED_PIN, 0);
@@ -76,23 +153,55 @@ void heartbeat(void* notUsed)
 
 void change_brightness(void* notUsed)
 {   
+#if POT_RGB
+    adc_scan_start();
+#else
+    const uint16_t *block;
+    adc_filter_t pot_filter;
+    uint16_t level;
+
+    adc_filter_init(&pot_filter, &pot_filter_config);
+    adc_capture_start();
+#endif
     while (true) {
-        uint16_t adc_raw_sample = adc_read();
-        if (adc_raw_sample < 30) {
-            adc_raw_sample = 0;
+        // Sleeps until a block is captured or a button edge comes in
+        ulTaskNotifyTakeIndexed(BUTTON_NOTIFY_INDEX, pdTRUE, portMAX_DELAY);
+        button_dispatch();
+#if POT_RGB
+        adc_scan_dispatch();
+#else
+        // Only a change the filter lets through touches the LED
+        while ((block = adc_capture_block()) != NULL) {
+            if (adc_filter_block(&pot_filter, block, ADC_BLOCK_LEN, &level)) {
+                pot_changed(ADC_INPUT, level, NULL);
+            }
         }
+#endif
+    }
+}
 
-        printf("ADC raw value: %d\n", adc_raw_sample);
-
-        gpio_pwm_level = adc_raw_sample << 4;
+// Runs in the brightness task, only when the filtered pot has moved. pin
+// is the pot's own color, or NULL for the one SW1 picks.
+void pot_changed(uint input, uint16_t value, void *pin) {
+    printf("pot %u level: %u\n", input, value);
+    if (pin) {
+        pwm_set_gpio_level((uintptr_t) pin, value);
+    } else {
+        gpio_pwm_level = value;
         pwm_set_gpio_level(cur_led_pin, gpio_pwm_level);
-        vTaskDelay(SAMPLE_DELAY);
     }
 }
 
-/* Interrupt functions */
-void gpio_int_callback(uint gpio, uint32_t events_unused) {
-    printf("in gpio callback\n");
+// T = 27 - (V - 0.706) / 0.001721, value is on a 16-bit scale of 3.3 V
+void temp_changed(uint input, uint16_t value, void *unused) {
+    int64_t uv = (int64_t) value * 3300000 / 65536;
+
+    temp_mc = 27000 - (uv - 706000) * 1000 / 1721;
+}
+
+// Runs in the brightness task, edges already debounced
+void button_pressed(uint gpio, button_event_t event, uint64_t time_us) {
+    printf("button %u at %llu us\n", gpio, time_us);
     if (gpio == SW1_PIN) {
         pwm_set_gpio_level(cur_led_pin, 0);
 
@@ -123,11 +232,10 @@ void hardware_init(void)
     gpio_init(PICO_DEFAULT_LED_PIN);
     gpio_set_dir(PICO_DEFAULT_LED_PIN, GPIO_OUT);
 
-    // GPIO SW pin
-    gpio_init(SW1_PIN);
-    gpio_pull_up(SW1_PIN);
-    gpio_set_dir(SW1_PIN, GPIO_IN);
-    gpio_set_irq_enabled_with_callback(SW1_PIN, GPIO_IRQ_EDGE_FALL, true, gpio_int_callback);
+    // GPIO SW pin, a pot per color leaves nothing to pick
+#if !POT_RGB
+    button_add(SW1_PIN, GPIO_IRQ_EDGE_FALL, BUTTON_DEBOUNCE_US, button_pressed);
+#endif
 
     // GPIO RED pin
     gpio_init(RED_PIN);
@@ -158,9 +266,4 @@ void hardware_init(void)
     pwm_init(slice_num_green, &config, true);
     pwm_init(slice_num_blue, &config, true);
     pwm_init(slice_num_red, &config, true);
-
-    // ADC init
-    adc_init();
-    adc_gpio_init(ADC_GPIO_PIN);
-    adc_select_input(ADC_INPUT);
 }
\ No newline at end of file
@@ -0,0 +1,21 @@
+; Two sine waves moving against each other, summed into hue, with the
+; brightness breathing over the whole strip
+.equ SAT, 255
+
+    shl  r3, r0, 2          ; a = sin(index * 4 + frame)
+    add  r3, r3, r1
+    sin  r4, r3
+    shl  r5, r0, 1          ; b = sin(index * 2 - frame * 3)
+    sub  r5, r5, r1
+    shl  r6, r1, 1
+    sub  r5, r5, r6
+    sin  r6, r5
+    add  r7, r4, r6         ; hue = (a + b) * 128
+    shl  r7, r7, 7
+    sin  r8, r1             ; value = 96 + sin(frame) * 5 / 8
+    ldi  r9, 160
+    mulq r8, r8, r9
+    addi r8, r8, 96
+    ldi  r9, SAT
+    hsv  r7, r9, r8
+    end
@@ -0,0 +1,7 @@
+; Rainbow scrolling along the strip, 1/1024 turn of hue per pixel
+    shl  r3, r0, 6          ; hue = index * 64
+    shl  r4, r1, 9          ;     + frame * 512
+    add  r3, r3, r4
+    ldi  r5, 255
+    hsv  r3, r5, r5
+    end
@@ -0,0 +1,23 @@
+; Dim blue tide with random white sparkles, about 1 pixel in 160 per frame.
+; Every sparkling pixel adds one to the sparkles count in memory.
+.var sparkles
+.equ CHANCE, 410            ; Of 65536
+
+    rnd  r3
+    ldi  r4, CHANCE
+    jlt  r3, r4, flash
+    shl  r5, r0, 3          ; blue = sin(index * 8 + frame * 2) / 4
+    shl  r6, r1, 1
+    add  r5, r5, r6
+    sin  r5, r5
+    shr  r5, r5, 2
+    ldi  r6, 0
+    rgb  r6, r6, r5
+    end
+flash:
+    ld   r7, sparkles
+    addi r7, r7, 1
+    st   r7, sparkles
+    ldi  r6, 255
+    rgb  r6, r6, r6
+    end
@@ -0,0 +1,261 @@
+/**
+ * @brief Addressable LED strips
+ *
+ * Two WS2812 strips on their own state machines. The first runs an
+ * effect script on the bytecode VM, a built-in one or one sent over USB as
+ * a line from fxasm.py --format hex, or "FX <name>" for a built-in. The
+ * second draws a rainbow crossfading with a slower copy of itself through
+ * the interpolator kernels. Frames are encoded into the back buffer while the front one is
+ * on the wire, and the swap waits for the strip's vsync.
+ * 
+ * Copyright (c) 2022 Alex Gavin
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+/* Defines */
+#define STRIP_A_PIN     2
+#define STRIP_B_PIN     3
+#define STRIP_LEDS      1000
+#define STRIP_RGBW      false
+
+#define BRIGHTNESS      64      // Of WS2812_SCALE_FULL, strips draw ~60 mA per pixel at full white
+#define REPORT_FRAMES   300
+#define BENCH_PASSES    20
+#define FX_LINE_MAX     (12 + 9 * (FXVM_CODE_WORDS + 2))
+
+/* Includes */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/stdio_usb.h"
+#include "hardware/clocks.h"
+#include "hardware/pio.h"
+
+#include "fxvm.h"
+#include "led_kern.h"
+#include "rgb_color.h"
+#include "ws2812.h"
+#include "fx_effects.h"
+
+/* Globals */
+static const struct {
+    const char *name;
+    const uint32_t *image;
+    size_t words;
+} builtin_fx[] = {
+    { "plasma", fx_plasma, count_of(fx_plasma) },
+    { "rainbow", fx_rainbow, count_of(fx_rainbow) },
+    { "sparkle", fx_sparkle, count_of(fx_sparkle) },
+};
+
+static fxvm_t vm;
+
+static uint32_t frames_a[2][STRIP_LEDS];
+static uint32_t frames_b[2][STRIP_LEDS];
+static ws2812_strip_t strip_a;
+static ws2812_strip_t strip_b;
+
+static rgb_t rainbow[256];
+static rgb_t pixels[STRIP_LEDS];
+static rgb_t layer[STRIP_LEDS];
+static uint8_t gamma8[256];
+
+// Cycles per pixel for each kernel, C and interpolator. The bench runs
+// before USB enumerates, the first report after it connects prints them.
+static uint32_t bench_cycles[4][2];
+static bool bench_match;
+static bool bench_printed;
+
+/* Prototypes */
+void draw(rgb_t *out, uint8_t offset, int dir);
+void kern_bench(void);
+void kern_bench_print(void);
+void fx_poll(void);
+void hardware_init(void);
+
+/* Code */
+int main()
+{
+    uint8_t offset = 0;
+    uint32_t frame = 0;
+    uint64_t busy_us = 0;
+    uint64_t vm_us = 0;
+    uint64_t vm_steps = 0;
+    uint64_t start = time_us_64();
+
+    stdio_init_all();
+    hardware_init();
+
+    for (uint i = 0; i < count_of(rainbow); i++) {
+        rainbow[i] = rgb_from_hsv((hsv_t) { .h = i << 8, .s = 255, .v = 255 });
+        gamma8[i] = rgb_gamma_lut[i] >> 8;
+    }
+    kern_bench();
+    fxvm_load(&vm, builtin_fx[0].image, builtin_fx[0].words);
+
+    while (1) {
+        fx_poll();
+
+        uint64_t t = time_us_64();
+        if (fxvm_frame(&vm, pixels, STRIP_LEDS, frame++) != FXVM_OK) {
+            printf("fx: over budget\n");
+        }
+        vm_us += time_us_64() - t;
+        vm_steps += vm.steps;
+        kern_lut8((uint8_t *) pixels, (uint8_t *) pixels, sizeof(pixels), gamma8);
+        ws2812_encode(&strip_a, pixels, BRIGHTNESS);
+
+        draw(pixels, offset, -1);
+        draw(layer, offset / 4, 1);
+        kern_lerp8((uint8_t *) pixels, (uint8_t *) pixels, (uint8_t *) layer, sizeof(pixels),
+                   offset);
+        kern_lut8((uint8_t *) pixels, (uint8_t *) pixels, sizeof(pixels), gamma8);
+        ws2812_encode(&strip_b, pixels, BRIGHTNESS);
+        busy_us += time_us_64() - t;
+
+        ws2812_swap(&strip_a);
+        ws2812_swap(&strip_b);
+        offset++;
+
+        if (strip_a.frames_sent >= REPORT_FRAMES) {
+            uint64_t elapsed = time_us_64() - start;
+
+            printf("strip: %lu fps, render+encode %llu us/frame, cpu %llu%%\n",
+                   (uint32_t) (strip_a.frames_sent * 1000000ull / elapsed),
+                   busy_us / strip_a.frames_sent, busy_us * 100 / elapsed);
+            printf("fx: %llu us/frame, %llu insns/pixel, %llu k insns/s\n",
+                   vm_us / strip_a.frames_sent, vm_steps / strip_a.frames_sent / STRIP_LEDS,
+                   vm_steps * 1000 / vm_us);
+            strip_a.frames_sent = 0;
+            busy_us = 0;
+            vm_us = 0;
+            vm_steps = 0;
+            start = time_us_64();
+
+            if (!bench_printed && stdio_usb_connected()) {
+                kern_bench_print();
+                bench_printed = true;
+            }
+        }
+    }
+}
+
+void draw(rgb_t *out, uint8_t offset, int dir)
+{
+    for (uint i = 0; i < STRIP_LEDS; i++) {
+        out[i] = rainbow[(uint8_t) (i + dir * offset)];
+    }
+}
+
+// Picks up "FX <name>" or "FX <hex words>" lines from USB without blocking.
+// A bad image is rejected by the loader and the running one kept.
+void fx_poll(void)
+{
+    static char line[FX_LINE_MAX];
+    static uint32_t image[FXVM_CODE_WORDS + 2];
+    static size_t len;
+    int c;
+
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        if (c != '\n' && c != '\r') {
+            if (len < sizeof(line) - 1) {
+                line[len++] = c;
+            }
+            continue;
+        }
+        line[len] = '\0';
+        len = 0;
+        if (strncmp(line, "FX ", 3) != 0) {
+            continue;
+        }
+
+        for (uint i = 0; i < count_of(builtin_fx); i++) {
+            if (strcmp(line + 3, builtin_fx[i].name) == 0) {
+                fxvm_load(&vm, builtin_fx[i].image, builtin_fx[i].words);
+                printf("fx: %s\n", builtin_fx[i].name);
+                return;
+            }
+        }
+
+        size_t words = 0;
+        char *p = line + 3;
+        while (*p && words < count_of(image)) {
+            char *end;
+            image[words] = strtoul(p, &end, 16);
+            if (end == p) {
+                break;
+            }
+            words++;
+            p = end;
+        }
+        printf("fx: load %d\n", fxvm_load(&vm, image, words));
+    }
+}
+
+// Clock cycles per pixel for the C and interpolator kernels over a whole
+// strip, and whether they agree
+void kern_bench(void)
+{
+    static uint8_t out_c[sizeof(pixels)];
+    static uint8_t out_i[sizeof(pixels)];
+    static uint16_t out16[sizeof(pixels)];
+    uint32_t mhz = clock_get_hz(clk_sys) / 1000000;
+    uint8_t *in = (uint8_t *) pixels;
+    uint8_t *out = (uint8_t *) layer;
+    size_t n = sizeof(pixels);
+
+    draw(pixels, 0, 1);
+    draw(layer, 128, 1);
+    for (int k = 0; k < 4; k++) {
+        uint64_t us[2];
+
+        for (int interp = 0; interp < 2; interp++) {
+            uint64_t start = time_us_64();
+            for (uint p = 0; p < BENCH_PASSES; p++) {
+                switch (k) {
+                    case 0:
+                        (interp ? kern_lut8_interp : kern_lut8_c)(out_c, in, n, gamma8);
+                        break;
+                    case 1:
+                        (interp ? kern_lut16_interp : kern_lut16_c)(out16, in, n, rgb_gamma_lut);
+                        break;
+                    case 2:
+                        (interp ? kern_lerp8_interp : kern_lerp8_c)(out_c, in, out, n, 77);
+                        break;
+                    default:
+                        (interp ? kern_scale8_interp : kern_scale8_c)(out_c, in, n, 77);
+                        break;
+                }
+            }
+            us[interp] = time_us_64() - start;
+        }
+        for (int interp = 0; interp < 2; interp++) {
+            bench_cycles[k][interp] = us[interp] * mhz / BENCH_PASSES / STRIP_LEDS;
+        }
+    }
+
+    // Same output both ways
+    kern_lerp8_c(out_c, in, out, n, 200);
+    kern_lerp8_interp(out_i, in, out, n, 200);
+    bench_match = memcmp(out_c, out_i, n) == 0;
+}
+
+void kern_bench_print(void)
+{
+    const char *names[] = { "lut8", "lut16", "lerp8", "scale8" };
+
+    for (int k = 0; k < 4; k++) {
+        printf("kern %-6s C %lu cycles/pixel, interp %lu cycles/pixel\n", names[k],
+               bench_cycles[k][0], bench_cycles[k][1]);
+    }
+    printf("kern lerp8 paths %s\n", bench_match ? "match" : "DIFFER");
+}
+
+/* Initialization functions */
+void hardware_init(void)
+{
+    ws2812_init(&strip_a, pio0, STRIP_A_PIN, frames_a[0], frames_a[1], STRIP_LEDS, STRIP_RGBW);
+    ws2812_init(&strip_b, pio0, STRIP_B_PIN, frames_b[0], frames_b[1], STRIP_LEDS, STRIP_RGBW);
+}